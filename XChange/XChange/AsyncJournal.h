@@ -0,0 +1,413 @@
+//
+//  AsyncJournal.h
+//  XChange
+//
+//  Created by Williams on 17/10/2026.
+//
+#pragma once
+#include "AsyncOrderBook.h"
+#include "Journal.h"
+#include "SpscRing.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <deque>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#include <sys/syscall.h>
+#define XCHANGE_JOURNAL_URING 1
+#endif
+
+// --- Journal writer stage off the matching thread ---
+//
+// The matcher hands each sequenced Command to a SPSC ring (on_sequenced()
+// is the engine's SequencedSink) and goes on matching. A writer thread
+// checksums records, copies them into page-aligned buffers and writes them
+// in the journal file format (JournalFileHeader + raw Commands) with
+// O_DIRECT | O_DSYNC, through io_uring where the kernel has it and pwrite
+// otherwise. A full buffer is submitted and the next one filled while it
+// is in flight; when the ring runs dry the open buffer's dirty pages are
+// written too, padded with zeros (group commit), and it is not touched
+// again until that write completes. Completions, in submission order,
+// advance durable_seq(): every command at or below it is on disk. Acks for
+// later commands must be held (DurableAckGate) until it catches up.
+//
+// A crash can leave zero padding after the last record; JournalReader stops
+// there. close() trims the file to its records.
+
+enum class JournalBackend : std::uint8_t { IoUring, Pwrite };
+
+struct AsyncJournalConfig {
+    std::size_t ring{1u << 16};            // records in flight between matcher and writer
+    std::size_t buffer_bytes{256 * 1024};  // per buffer; a multiple of 4096
+    std::size_t buffers{8};                // writes in flight is at most buffers
+    bool        use_uring{true};           // false: always pwrite
+    bool        direct{true};              // O_DIRECT where the filesystem allows it
+};
+
+namespace async_journal_detail {
+
+inline constexpr std::size_t kPage = 4096;
+
+inline std::size_t align_down(std::size_t n) { return n & ~(kPage - 1); }
+inline std::size_t align_up(std::size_t n) { return align_down(n + kPage - 1); }
+
+#ifdef XCHANGE_JOURNAL_URING
+// Just enough io_uring for one writer: raw syscalls, no liburing.
+class Uring {
+public:
+    explicit Uring(unsigned entries) {
+        io_uring_params p{};
+        fd_ = static_cast<int>(::syscall(__NR_io_uring_setup, entries, &p));
+        if (fd_ < 0) return;
+        sq_bytes_ = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+        cq_bytes_ = p.cq_off.cqes + p.cq_entries * sizeof(io_uring_cqe);
+        if (p.features & IORING_FEAT_SINGLE_MMAP) sq_bytes_ = cq_bytes_ = std::max(sq_bytes_, cq_bytes_);
+        sq_ = ::mmap(nullptr, sq_bytes_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd_, IORING_OFF_SQ_RING);
+        cq_ = p.features & IORING_FEAT_SINGLE_MMAP
+            ? sq_
+            : ::mmap(nullptr, cq_bytes_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd_, IORING_OFF_CQ_RING);
+        sqe_bytes_ = p.sq_entries * sizeof(io_uring_sqe);
+        void *sqes = ::mmap(nullptr, sqe_bytes_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd_, IORING_OFF_SQES);
+        if (sq_ == MAP_FAILED || cq_ == MAP_FAILED || sqes == MAP_FAILED) {
+            release();
+            return;
+        }
+        auto sq = static_cast<char *>(sq_), cq = static_cast<char *>(cq_);
+        sq_tail_ = reinterpret_cast<unsigned *>(sq + p.sq_off.tail);
+        sq_mask_ = *reinterpret_cast<unsigned *>(sq + p.sq_off.ring_mask);
+        sq_array_ = reinterpret_cast<unsigned *>(sq + p.sq_off.array);
+        sqes_ = static_cast<io_uring_sqe *>(sqes);
+        cq_head_ = reinterpret_cast<unsigned *>(cq + p.cq_off.head);
+        cq_tail_ = reinterpret_cast<unsigned *>(cq + p.cq_off.tail);
+        cq_mask_ = *reinterpret_cast<unsigned *>(cq + p.cq_off.ring_mask);
+        cqes_ = reinterpret_cast<io_uring_cqe *>(cq + p.cq_off.cqes);
+    }
+    ~Uring() { release(); }
+    Uring(const Uring &) = delete;
+    Uring &operator=(const Uring &) = delete;
+
+    bool ok() const { return sqes_ != nullptr; }
+
+    // Queues and submits one write. The caller keeps at most `entries`
+    // writes in flight, so the SQ never overflows.
+    bool write(int fd, const void *buf, std::size_t len, std::size_t off, std::uint64_t tag) {
+        unsigned tail = *sq_tail_;
+        unsigned idx = tail & sq_mask_;
+        io_uring_sqe &sqe = sqes_[idx];
+        std::memset(&sqe, 0, sizeof(sqe));
+        sqe.opcode = IORING_OP_WRITE;
+        sqe.fd = fd;
+        sqe.addr = reinterpret_cast<std::uint64_t>(buf);
+        sqe.len = static_cast<std::uint32_t>(len);
+        sqe.off = off;
+        sqe.user_data = tag;
+        sq_array_[idx] = idx;
+        std::atomic_ref<unsigned>(*sq_tail_).store(tail + 1, std::memory_order_release);
+        return ::syscall(__NR_io_uring_enter, fd_, 1, 0, 0, nullptr, 0) == 1;
+    }
+
+    // Calls f(tag, res) per completion; blocks for at least one if `wait`.
+    template <typename F>
+    std::size_t reap(bool wait, F &&f) {
+        if (wait) ::syscall(__NR_io_uring_enter, fd_, 0, 1, IORING_ENTER_GETEVENTS, nullptr, 0);
+        unsigned head = *cq_head_;
+        unsigned tail = std::atomic_ref<unsigned>(*cq_tail_).load(std::memory_order_acquire);
+        std::size_t n = 0;
+        for (; head != tail; ++head, ++n) {
+            const io_uring_cqe &cqe = cqes_[head & cq_mask_];
+            f(cqe.user_data, cqe.res);
+        }
+        std::atomic_ref<unsigned>(*cq_head_).store(head, std::memory_order_release);
+        return n;
+    }
+
+private:
+    void release() {
+        if (sqes_) ::munmap(sqes_, sqe_bytes_);
+        if (cq_ && cq_ != MAP_FAILED && cq_ != sq_) ::munmap(cq_, cq_bytes_);
+        if (sq_ && sq_ != MAP_FAILED) ::munmap(sq_, sq_bytes_);
+        if (fd_ >= 0) ::close(fd_);
+        sqes_ = nullptr;
+        sq_ = cq_ = nullptr;
+        fd_ = -1;
+    }
+
+    int fd_ = -1;
+    void *sq_ = nullptr, *cq_ = nullptr;
+    std::size_t sq_bytes_ = 0, cq_bytes_ = 0, sqe_bytes_ = 0;
+    unsigned *sq_tail_ = nullptr, *sq_array_ = nullptr, sq_mask_ = 0;
+    unsigned *cq_head_ = nullptr, *cq_tail_ = nullptr, cq_mask_ = 0;
+    io_uring_sqe *sqes_ = nullptr;
+    io_uring_cqe *cqes_ = nullptr;
+};
+#endif
+
+} // namespace async_journal_detail
+
+class AsyncJournalWriter {
+public:
+    // Creates (or truncates) `path`.
+    explicit AsyncJournalWriter(const std::string &path, AsyncJournalConfig cfg = {})
+        : cfg_(cfg), ring_(cfg.ring) {
+        using namespace async_journal_detail;
+        if (cfg_.buffer_bytes == 0 || cfg_.buffer_bytes % kPage != 0 || cfg_.buffers < 2)
+            throw std::runtime_error("journal: buffer_bytes must be a multiple of 4096 and buffers >= 2");
+        int flags = O_WRONLY | O_CREAT | O_TRUNC | O_DSYNC;
+#ifdef O_DIRECT
+        if (cfg_.direct) {
+            fd_ = ::open(path.c_str(), flags | O_DIRECT, 0644);
+            direct_ = fd_ >= 0;
+        }
+#endif
+        if (fd_ < 0) fd_ = ::open(path.c_str(), flags, 0644);
+        if (fd_ < 0) throw std::runtime_error("journal: cannot open " + path);
+#if !defined(O_DIRECT) && defined(F_NOCACHE)
+        if (cfg_.direct) direct_ = ::fcntl(fd_, F_NOCACHE, 1) == 0;
+#endif
+#ifdef XCHANGE_JOURNAL_URING
+        if (cfg_.use_uring) {
+            uring_ = std::make_unique<Uring>(static_cast<unsigned>(cfg_.buffers));
+            if (!uring_->ok()) uring_.reset();
+        }
+#endif
+        for (std::size_t i = 0; i < cfg_.buffers; ++i) {
+            void *p = std::aligned_alloc(kPage, cfg_.buffer_bytes);
+            if (!p) throw std::bad_alloc();
+            std::memset(p, 0, cfg_.buffer_bytes); // fault in now, not on the first record
+            bufs_.push_back({static_cast<char *>(p), 0});
+        }
+        JournalFileHeader h{};
+        std::memcpy(bufs_[0].data, &h, sizeof(h));
+        fill_ = sizeof(h);
+        writer_ = std::thread([this] { run(); });
+    }
+
+    ~AsyncJournalWriter() {
+        close();
+        for (auto &b : bufs_) std::free(b.data);
+    }
+    AsyncJournalWriter(const AsyncJournalWriter &) = delete;
+    AsyncJournalWriter &operator=(const AsyncJournalWriter &) = delete;
+
+    // Matching thread: never blocks on I/O; spins only if the ring is full.
+    void on_sequenced(const Command &c) { ring_.push(c); }
+
+    AsyncMatchingEngine::SequencedSink sink() {
+        return [this](const Command &c) { on_sequenced(c); };
+    }
+
+    // Every command with seq <= this is on disk.
+    SeqNo durable_seq() const { return durable_.load(std::memory_order_acquire); }
+
+    // Blocks until `seq` is durable; false if the journal failed first.
+    bool wait_durable(SeqNo seq) {
+        std::unique_lock<std::mutex> lk(m_);
+        cv_.wait(lk, [&] { return failed_ || durable_.load(std::memory_order_acquire) >= seq; });
+        return durable_.load(std::memory_order_acquire) >= seq;
+    }
+
+    // A write failed; durable_seq() stops where it was.
+    bool failed() const {
+        std::lock_guard<std::mutex> lk(m_);
+        return failed_;
+    }
+
+    JournalBackend backend() const {
+#ifdef XCHANGE_JOURNAL_URING
+        if (uring_) return JournalBackend::IoUring;
+#endif
+        return JournalBackend::Pwrite;
+    }
+    bool direct() const { return direct_; }
+    std::uint64_t writes() const { return writes_.load(std::memory_order_relaxed); }
+
+    // Call once the producer is done: writes what is queued, waits for it,
+    // trims the padding and closes the file.
+    void close() {
+        if (closing_.exchange(true)) return;
+        if (writer_.joinable()) writer_.join();
+        if (::ftruncate(fd_, static_cast<off_t>(base_ + fill_)) == 0) ::fsync(fd_);
+        ::close(fd_);
+    }
+
+private:
+    struct Buffer {
+        char *data;
+        int   busy; // writes in flight from this buffer
+    };
+    struct Write {
+        std::size_t buffer;
+        std::size_t bytes;
+        SeqNo       through; // last record wholly inside this write and those before it
+        bool        done;
+    };
+
+    void run() {
+        std::size_t idle = 0;
+        Command c;
+        for (;;) {
+            if (ring_.try_pop(c)) {
+                idle = 0;
+                append(c);
+                continue;
+            }
+            if (dirty()) { // ring ran dry: commit what we have
+                submit(fill_);
+                continue;
+            }
+            reap(false);
+            if (closing_.load(std::memory_order_acquire)) {
+                if (ring_.try_pop(c)) { append(c); continue; }
+                while (!inflight_.empty()) reap(true);
+                return;
+            }
+            if (++idle < 256) std::this_thread::yield();
+            else std::this_thread::sleep_for(std::chrono::microseconds(20));
+        }
+    }
+
+    bool dirty() const { return fill_ > submitted_; }
+
+    // Copies one record into the open buffer, moving to the next buffer when
+    // it fills; a record may straddle two buffers.
+    void append(Command c) {
+        c.crc = journal_record_crc(c); // here, not on the matcher
+        auto src = reinterpret_cast<const char *>(&c);
+        std::size_t left = sizeof(c);
+        while (left > 0) {
+            while (bufs_[cur_].busy > 0) reap(true); // a group-commit write still reads it
+            std::size_t n = std::min(left, cfg_.buffer_bytes - fill_);
+            std::memcpy(bufs_[cur_].data + fill_, src, n);
+            fill_ += n;
+            src += n;
+            left -= n;
+            if (fill_ == cfg_.buffer_bytes) next_buffer();
+        }
+        last_ = c.seq;
+    }
+
+    void next_buffer() {
+        submit(cfg_.buffer_bytes);
+        cur_ = (cur_ + 1) % bufs_.size();
+        while (bufs_[cur_].busy > 0) reap(true);
+        base_ += cfg_.buffer_bytes;
+        fill_ = submitted_ = 0;
+    }
+
+    // Writes the open buffer's pages from the first dirty one through `end`
+    // (rounded up to a page, zero padded).
+    void submit(std::size_t end) {
+        using namespace async_journal_detail;
+        std::size_t from = align_down(submitted_), to = align_up(end);
+        Buffer &b = bufs_[cur_];
+        std::memset(b.data + end, 0, to - end);
+        submitted_ = end;
+        ++b.busy;
+        inflight_.push_back({cur_, to - from, last_, false});
+        std::uint64_t tag = first_tag_ + inflight_.size() - 1;
+        writes_.fetch_add(1, std::memory_order_relaxed);
+#ifdef XCHANGE_JOURNAL_URING
+        if (uring_) {
+            if (!uring_->write(fd_, b.data + from, to - from, base_ + from, tag)) complete(tag, false);
+            return;
+        }
+#endif
+        ssize_t w = ::pwrite(fd_, b.data + from, to - from, static_cast<off_t>(base_ + from));
+        complete(tag, w == static_cast<ssize_t>(to - from));
+    }
+
+    void reap(bool wait) {
+#ifdef XCHANGE_JOURNAL_URING
+        if (uring_ && !inflight_.empty()) {
+            uring_->reap(wait, [&](std::uint64_t tag, int res) {
+                complete(tag, res == static_cast<int>(inflight_[tag - first_tag_].bytes));
+            });
+            return;
+        }
+#endif
+        (void)wait; // pwrite completes in submit()
+    }
+
+    void complete(std::uint64_t tag, bool ok) {
+        if (!ok) fail();
+        inflight_[tag - first_tag_].done = true;
+        SeqNo through = 0;
+        while (!inflight_.empty() && inflight_.front().done) {
+            --bufs_[inflight_.front().buffer].busy;
+            through = inflight_.front().through;
+            inflight_.pop_front();
+            ++first_tag_;
+        }
+        if (through == 0 || failed_flag_) return;
+        {
+            std::lock_guard<std::mutex> lk(m_);
+            durable_.store(through, std::memory_order_release);
+        }
+        cv_.notify_all();
+    }
+
+    void fail() {
+        failed_flag_ = true;
+        {
+            std::lock_guard<std::mutex> lk(m_);
+            failed_ = true;
+        }
+        cv_.notify_all();
+    }
+
+    AsyncJournalConfig cfg_;
+    SpscRing<Command> ring_;
+    int fd_ = -1;
+    bool direct_ = false;
+#ifdef XCHANGE_JOURNAL_URING
+    using Uring = async_journal_detail::Uring;
+    std::unique_ptr<Uring> uring_; // null: pwrite
+#endif
+
+    // Writer thread only.
+    std::vector<Buffer> bufs_;
+    std::size_t cur_ = 0;        // open buffer
+    std::size_t base_ = 0;       // its file offset
+    std::size_t fill_ = 0;       // bytes in it
+    std::size_t submitted_ = 0;  // bytes of it already handed to a write
+    SeqNo last_ = 0;             // last record wholly copied
+    std::deque<Write> inflight_; // submission order
+    std::uint64_t first_tag_ = 0;
+    bool failed_flag_ = false;
+
+    mutable std::mutex m_;
+    std::condition_variable cv_;
+    bool failed_ = false;
+    std::atomic<SeqNo> durable_{0};
+    std::atomic<std::uint64_t> writes_{0};
+    std::atomic<bool> closing_{false};
+    std::thread writer_;
+};
+
+// --- Gateway side: acks go out only once their command is durable ---
+class DurableAckGate {
+public:
+    // Acks must be held in seq order (the order the engine emits them).
+    void hold(const Ack &a) { held_.push_back(a); }
+
+    // Passes every held ack with seq <= durable to f, oldest first.
+    template <typename F>
+    std::size_t release(SeqNo durable, F &&f) {
+        std::size_t n = 0;
+        for (; !held_.empty() && held_.front().seq <= durable; ++n) {
+            f(held_.front());
+            held_.pop_front();
+        }
+        return n;
+    }
+
+    std::size_t held() const { return held_.size(); }
+
+private:
+    std::deque<Ack> held_;
+};
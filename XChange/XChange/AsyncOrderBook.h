@@ -0,0 +1,564 @@
+//
+//  AsyncOrderBook.h
+//  XChange
+//
+//  Created by Williams on 10/09/2025.
+//
+#pragma once
+#include "DepthView.h"
+#include "FlightRecorder.h"
+#include "Instruments.h"
+#include "Metrics.h"
+#include "OrderBook.h"
+
+// --- ConcurrentQueue for async ingress/egress (MPMC, mutex+cv) ---
+template <typename T>
+class ConcurrentQueue {
+public:
+    // Nodes are only (de)allocated under m_, so `mr` need not be thread-safe.
+    explicit ConcurrentQueue(std::pmr::memory_resource *mr = std::pmr::get_default_resource())
+        : mr_(mr), q_(std::pmr::deque<T>(mr)) {}
+
+    // Runs `n` elements' worth of blocks through `mr` so a pool in front of
+    // it already holds them when traffic starts.
+    void prewarm(std::size_t n) {
+        std::lock_guard<std::mutex> lk(m_);
+        std::pmr::deque<T> tmp(mr_);
+        tmp.resize(n);
+    }
+
+    void push(T v) {
+        {
+            std::lock_guard<std::mutex> lk(m_);
+            if (closed_) return; // drop if closed
+            q_.push(std::move(v));
+        }
+        cv_.notify_one();
+    }
+
+    // Blocking pop; returns false if queue closed and empty
+    bool pop(T &out) {
+        std::unique_lock<std::mutex> lk(m_);
+        cv_.wait(lk, [&]{ return closed_ || !q_.empty(); });
+        if (q_.empty()) return false; // closed and drained
+        out = std::move(q_.front());
+        q_.pop();
+        return true;
+    }
+
+    // Blocks like pop(), then takes up to `max` items under the one lock.
+    // Returns 0 only if the queue is closed and drained.
+    std::size_t pop_batch(std::vector<T> &out, std::size_t max) {
+        out.clear();
+        std::unique_lock<std::mutex> lk(m_);
+        cv_.wait(lk, [&]{ return closed_ || !q_.empty(); });
+        while (!q_.empty() && out.size() < max) {
+            out.push_back(std::move(q_.front()));
+            q_.pop();
+        }
+        return out.size();
+    }
+
+    // Pushes all of `items` under one lock and one notify.
+    void push_all(std::vector<T> &items) {
+        if (items.empty()) return;
+        {
+            std::lock_guard<std::mutex> lk(m_);
+            if (closed_) return; // drop if closed
+            for (auto &v : items) q_.push(std::move(v));
+        }
+        cv_.notify_all();
+        items.clear();
+    }
+
+    bool try_pop(T &out) {
+        std::lock_guard<std::mutex> lk(m_);
+        if (q_.empty()) return false;
+        out = std::move(q_.front());
+        q_.pop();
+        return true;
+    }
+
+    // Momentary depth; takes the lock, so meant for samplers, not hot paths.
+    std::size_t size() {
+        std::lock_guard<std::mutex> lk(m_);
+        return q_.size();
+    }
+
+    void close() {
+        {
+            std::lock_guard<std::mutex> lk(m_);
+            closed_ = true;
+        }
+        cv_.notify_all();
+    }
+
+private:
+    std::mutex m_;
+    std::condition_variable cv_;
+    std::pmr::memory_resource *mr_;
+    std::queue<T, std::pmr::deque<T>> q_;
+    bool closed_ = false;
+};
+
+// Raw tsc_now() ticks taken on the hot path; convert with TscClock::to_ns().
+struct EngineStamps {
+    TscTicks ingress{};     // submit() on the producer thread
+    TscTicks match_start{}; // worker dequeued the command
+    TscTicks match_end{};   // add_order() returned
+    TscTicks egress{};      // a consumer took the event off the egress queue
+};
+
+enum class AckStatus : std::uint8_t {
+    Accepted,
+    Rejected,
+    Cancelled,
+    CancelRejected,
+    Halted, // accepted, but the book is halted: what did not fill rests for the auction
+};
+
+// Response to a command submitted with a non-zero RequestId.
+struct Ack {
+    RequestId    request{};
+    OrderId      order{};
+    SeqNo        seq{};    // sequence number the command was applied at; 0 for Rejected (never sequenced)
+    AckStatus    status{};
+    RejectReason reason{}; // for Rejected and CancelRejected
+    Qty          filled{}; // for Accepted and Halted: traded on arrival (for a resume: in the auction)
+    Qty          leaves{}; // for Accepted and Halted: left resting
+};
+
+// Halted follows the command that halted the book (summary.taker_id is the
+// order that tripped the breaker, 0 for an auction open). Resumed follows
+// the auction's TradeBatch; its summary totals the auction, with
+// last_price the uncross price (0 if the book was not crossed).
+struct EngineEvent {
+    enum class Type { TradeBatch, BookSnapshot, Execution, Acks, Halted, Resumed } type{Type::TradeBatch};
+    std::vector<Trade> trades; // for TradeBatch
+    ExecutionSummary summary{}; // for Execution, Halted, Resumed, and TradeBatch under TradeReporting::Both
+    EngineStamps stamps{};
+    std::vector<Ack> acks;     // for Acks, in command order
+};
+
+// What the engine publishes for an order that trades.
+enum class TradeReporting : std::uint8_t {
+    Trades,  // one TradeBatch with every maker fill
+    Summary, // one Execution event with the taker's totals; no per-maker trades are built
+    Both,    // TradeBatch carrying the summary as well
+};
+
+// Synthetic session the worker runs before taking real orders, so pools,
+// index buckets, thread-local rings and vectors are already allocated and
+// faulted in when the first order arrives.
+struct WarmupConfig {
+    std::size_t orders = 0;      // resting orders cycled through the book; 0 = no warm-up
+    Price       base_price = 100;
+    Price       levels = 64;     // distinct prices per side
+};
+
+struct StartupReport {
+    std::chrono::nanoseconds prewarm{};   // reserve + pool/queue prefill + thread-locals
+    std::chrono::nanoseconds synthetic{}; // warm-up flow through the match code
+    std::chrono::nanoseconds total{};     // construction -> ready
+    std::size_t              warm_orders{};
+    std::size_t              warm_trades{};
+};
+
+// Warm-up order ids; never seen outside the worker.
+inline constexpr OrderId kWarmupIdBit = OrderId{1} << 62;
+
+// --- Async wrapper around OrderBook ---
+class AsyncMatchingEngine {
+public:
+    // Called on the matching thread for every command, after it is sequenced
+    // and before it is applied (e.g. to feed a hot standby).
+    using SequencedSink = std::function<void(const Command &)>;
+
+    // `upstream` backs the book and both queues (e.g. a HugePageResource);
+    // each gets its own pool in front of it.
+    // With `warmup.orders` set, the worker warms up before taking orders;
+    // wait_ready() returns once it has.
+    explicit AsyncMatchingEngine(SequencedSink on_sequenced = {},
+                                 std::pmr::memory_resource *upstream = std::pmr::get_default_resource(),
+                                 WarmupConfig warmup = {})
+        : book_pool_(upstream), inq_pool_(upstream), outq_pool_(upstream),
+          book_(&book_pool_), inq_(&inq_pool_), outq_(&outq_pool_),
+          on_sequenced_(std::move(on_sequenced)), warmup_(warmup), running_(true), worker_([this]{ run(); }) {}
+    ~AsyncMatchingEngine() {
+        shutdown();
+    }
+
+    // With a non-zero `request`, the engine answers with an Ack carrying it.
+    // Acks for one batch are coalesced into a single Acks event, published
+    // ahead of that batch's trades, so a client can keep any number of
+    // requests in flight and match the answers up by id.
+    void submit(Order o, Display display = Display::Lit, RequestId request = 0) {
+        Command c{};
+        c.display = display;
+        c.order = std::move(o);
+        c.ingress_tsc = tsc_now();
+        c.request = request;
+        inq_.push(c);
+    }
+
+    void cancel(OrderId id, RequestId request = 0) {
+        Command c{};
+        c.type = Command::Type::Cancel;
+        c.order.id = id;
+        c.ingress_tsc = tsc_now();
+        c.request = request;
+        inq_.push(c);
+    }
+
+    // Cancels `orig` and, if it was still resting, enters `o` in its place
+    // (at the back of its level). If `orig` is gone the answer is
+    // CancelRejected and `o` is not entered; if `o` is Rejected, `orig`
+    // stays as it was.
+    void replace(OrderId orig, Order o, Display display = Display::Lit, RequestId request = 0) {
+        Command c{};
+        c.type = Command::Type::Replace;
+        c.display = display;
+        c.order = std::move(o);
+        c.ingress_tsc = tsc_now();
+        c.request = request;
+        c.replaces = orig;
+        inq_.push(c);
+    }
+
+    // Ends a halt (a breaker trip, or an instrument that opened in
+    // auction): the worker uncrosses the book and publishes the auction
+    // trades as a TradeBatch, whatever the TradeReporting, then Resumed
+    // with the auction's totals.
+    // Sequenced like any command, so a standby uncrosses at the same point.
+    void resume(RequestId request = 0) {
+        Command c{};
+        c.type = Command::Type::Resume;
+        c.ingress_tsc = tsc_now();
+        c.request = request;
+        inq_.push(c);
+    }
+
+    // Both stamp stamps.egress as the event leaves the queue.
+    bool poll_event(EngineEvent &ev) { return outq_.try_pop(ev) && stamp_egress(ev); }
+
+    bool wait_event(EngineEvent &ev) { return outq_.pop(ev) && stamp_egress(ev); }
+
+    std::optional<Price> best_bid() const { return book_.best_bid(); }
+    std::optional<Price> best_ask() const { return book_.best_ask(); }
+
+    // Most commands the worker takes per wake-up (1 = no batching).
+    void set_max_batch(std::size_t n) { max_batch_.store(std::max<std::size_t>(1, n), std::memory_order_relaxed); }
+
+    void set_trade_reporting(TradeReporting r) { reporting_.store(r, std::memory_order_relaxed); }
+
+    // Publishes a DepthSnapshot after every batch while on; the first batch
+    // after switching on mirrors the whole book, later ones patch it.
+    void set_depth_view(bool on) { depth_view_.store(on, std::memory_order_relaxed); }
+
+    // Blocks until the worker has finished warming up.
+    StartupReport wait_ready() {
+        std::unique_lock<std::mutex> lk(ready_m_);
+        ready_cv_.wait(lk, [&]{ return ready_; });
+        return report_;
+    }
+
+    // Tick/lot rules, price controls and policy for this engine's book. Taken
+    // up by the worker before its next batch, which sequences the controls
+    // as a Controls command so a standby or replay applies the same bands
+    // and halt. Orders that fail tick, lot or band are rejected
+    // (xchange_rejects_total) without being sequenced.
+    void set_instrument(const InstrumentSpec &spec) {
+        std::lock_guard<std::mutex> lk(pending_m_);
+        pending_spec_ = spec;
+        spec_pending_.store(true, std::memory_order_release);
+    }
+
+    // Consistent full-depth reads from any thread; never blocks the matcher.
+    DepthPublisher::Reader depth_reader() { return depth_.reader(); }
+
+    // Queue depths for metrics samplers.
+    std::size_t inbound_depth() { return inq_.size(); }
+    std::size_t outbound_depth() { return outq_.size(); }
+
+    void shutdown() {
+        bool expected = true;
+        if (running_.compare_exchange_strong(expected, false)) {
+            inq_.close();   // wake worker waiting on pop
+            if (worker_.joinable()) worker_.join();
+            outq_.close();  // wake any consumers
+        }
+    }
+
+private:
+    static bool stamp_egress(EngineEvent &ev) {
+        ev.stamps.egress = tsc_now();
+        return true;
+    }
+
+    // Drains up to max_batch_ commands per wake-up: one lock to dequeue, one
+    // to publish their events, one gauge update. Commands are still applied
+    // strictly in arrival order.
+    void run() {
+        std::vector<Command> batch;
+        std::vector<EngineEvent> events;
+        warm_up(batch, events);
+        while (running_) {
+            if (inq_.pop_batch(batch, max_batch_.load(std::memory_order_relaxed)) == 0) break; // closed & drained
+            clock_ns_ = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch()).count();
+            if (spec_pending_.load(std::memory_order_acquire)) take_instrument(events);
+            bool depth = depth_view_.load(std::memory_order_relaxed);
+            if (depth != tracking_depth_) {
+                tracking_depth_ = depth;
+                depth_.reset();
+            }
+            for (auto &c : batch) {
+                apply(c, events);
+                note_halt(c, events);
+            }
+            if (!acks_.empty()) {
+                EngineEvent ev;
+                ev.type = EngineEvent::Type::Acks;
+                ev.acks = std::move(acks_);
+                acks_.clear();
+                events.insert(events.begin(), std::move(ev));
+            }
+            if (tracking_depth_) depth_.update(book_, seq_);
+            publish_book_gauges();
+            outq_.push_all(events);
+        }
+    }
+
+    // Rejects are decided before sequencing: they are answered (with seq 0)
+    // but never reach on_sequenced_, so the journal and a standby only ever
+    // see commands the book took.
+    void apply(Command &c, std::vector<EngineEvent> &events) {
+        TscTicks match_start = tsc_now();
+        const Order &o = c.order;
+        auto side = static_cast<std::uint8_t>(o.side);
+        EngineMetrics::observe(Histogram::QueueTicks, match_start - c.ingress_tsc);
+        bool entering = c.type == Command::Type::NewOrder || c.type == Command::Type::Replace;
+        if (entering) {
+            RejectReason why = rules_.validate(o.price, o.qty);
+            if (why == RejectReason::None && !book_.in_band(o.price)) why = RejectReason::PriceBand;
+            if (why != RejectReason::None) {
+                FlightRecorder::record(FlightEventType::NewOrder, 0, o.id, 0, o.price, o.qty, side);
+                EngineMetrics::inc(Counter::Rejects);
+                ack(c, AckStatus::Rejected, why); // a Replace leaves the original in place
+                return;
+            }
+        }
+        sequence(c);
+        if (c.type == Command::Type::Resume) {
+            uncross(c, match_start, events);
+            return;
+        }
+        if (entering) FlightRecorder::record(FlightEventType::NewOrder, c.seq, o.id, 0, o.price, o.qty, side);
+        if (c.type != Command::Type::NewOrder) {
+            OrderId id = c.type == Command::Type::Cancel ? o.id : c.replaces;
+            FlightRecorder::record(FlightEventType::Cancel, c.seq, id);
+            EngineMetrics::inc(Counter::Cancels);
+            if (tracking_depth_)
+                if (auto at = book_.locate(id)) depth_.touch(at->first, at->second);
+            if (c.type == Command::Type::Cancel) {
+                if (!book_.cancel(id)) {
+                    EngineMetrics::inc(Counter::CancelMisses);
+                    ack(c, AckStatus::CancelRejected, RejectReason::UnknownOrder);
+                    return;
+                }
+                FlightRecorder::record(FlightEventType::BookRemove, c.seq, id);
+                ack(c, AckStatus::Cancelled);
+                return;
+            }
+        }
+        TradeReporting reporting = reporting_.load(std::memory_order_relaxed);
+        std::vector<Trade> trades;
+        ExecutionSummary sum;
+        std::vector<Trade> *out = reporting == TradeReporting::Summary ? nullptr : &trades;
+        std::optional<AddResult> result = c.type == Command::Type::Replace
+                                              ? book_.replace(c.replaces, o, out, sum, c.display)
+                                              : book_.add_order(o, out, sum, c.display);
+        TscTicks match_end = tsc_now();
+        EngineMetrics::observe(Histogram::MatchTicks, match_end - match_start);
+        if (!result) {
+            EngineMetrics::inc(Counter::CancelMisses);
+            ack(c, AckStatus::CancelRejected, RejectReason::UnknownOrder);
+            return;
+        }
+        if (*result == AddResult::Rejected) { // a Replace leaves the original in place
+            EngineMetrics::inc(Counter::Rejects);
+            ack(c, AckStatus::Rejected, RejectReason::PriceBand);
+            return;
+        }
+        if (c.type == Command::Type::Replace) FlightRecorder::record(FlightEventType::BookRemove, c.seq, c.replaces);
+        EngineMetrics::inc(Counter::Orders);
+        ack(c, book_.halted() ? AckStatus::Halted : AckStatus::Accepted, RejectReason::None, sum.filled_qty,
+            sum.leaves_qty);
+        for (auto const &t : trades)
+            FlightRecorder::record(FlightEventType::Trade, c.seq, t.maker_id, t.taker_id, t.price, t.qty);
+        EngineMetrics::inc(Counter::Trades, sum.fills);
+        EngineMetrics::inc(Counter::TradedQty, static_cast<std::uint64_t>(sum.filled_qty));
+        if (sum.fills)
+            FlightRecorder::record(FlightEventType::Execution, c.seq, o.id, sum.levels_touched, sum.last_price,
+                                   sum.filled_qty, side);
+        if (tracking_depth_) {
+            if (sum.fills) depth_.touch(o.side == Side::Buy ? Side::Sell : Side::Buy, sum.first_price, sum.last_price);
+            if (sum.leaves_qty > 0) depth_.touch(o.side, o.price);
+        }
+        if (sum.leaves_qty > 0)
+            FlightRecorder::record(FlightEventType::BookAdd, c.seq, o.id, 0, o.price, sum.leaves_qty, side);
+        FlightRecorder::record(FlightEventType::Stamp, c.seq, o.id, c.ingress_tsc);
+        if (sum.fills == 0) return;
+        EngineStamps stamps{c.ingress_tsc, match_start, match_end, 0};
+        if (reporting == TradeReporting::Summary)
+            events.push_back(EngineEvent{EngineEvent::Type::Execution, {}, sum, stamps, {}});
+        else
+            events.push_back(EngineEvent{EngineEvent::Type::TradeBatch, std::move(trades),
+                                         reporting == TradeReporting::Both ? sum : ExecutionSummary{}, stamps, {}});
+    }
+
+    // Numbers `c`, stamps it with the batch's clock (the breaker's time
+    // base, journaled with it) and hands it to on_sequenced_.
+    void sequence(Command &c) {
+        c.seq = ++seq_;
+        c.clock_ns = clock_ns_;
+        book_.set_clock(clock_ns_);
+        if (on_sequenced_) on_sequenced_(c);
+    }
+
+    void uncross(const Command &c, TscTicks match_start, std::vector<EngineEvent> &events) {
+        std::vector<Trade> trades;
+        auto px = book_.resume(trades);
+        TscTicks match_end = tsc_now();
+        EngineMetrics::observe(Histogram::MatchTicks, match_end - match_start);
+        halted_ = false;
+        ExecutionSummary sum;
+        for (auto const &t : trades) {
+            sum.record(t.price, t.qty);
+            FlightRecorder::record(FlightEventType::Trade, c.seq, t.maker_id, t.taker_id, t.price, t.qty);
+        }
+        sum.last_price = px.value_or(0);
+        EngineMetrics::inc(Counter::Trades, sum.fills);
+        EngineMetrics::inc(Counter::TradedQty, static_cast<std::uint64_t>(sum.filled_qty));
+        if (tracking_depth_) depth_.reset(); // levels on both sides of the uncross price went
+        ack(c, AckStatus::Accepted, RejectReason::None, sum.filled_qty, 0);
+        EngineStamps stamps{c.ingress_tsc, match_start, match_end, 0};
+        if (!trades.empty())
+            events.push_back(EngineEvent{EngineEvent::Type::TradeBatch, std::move(trades),
+                                         reporting_.load(std::memory_order_relaxed) == TradeReporting::Both
+                                             ? sum
+                                             : ExecutionSummary{},
+                                         stamps, {}});
+        events.push_back(EngineEvent{EngineEvent::Type::Resumed, {}, sum, stamps, {}});
+    }
+
+    // Publishes Halted once per halt, after the command that caused it.
+    void note_halt(const Command &c, std::vector<EngineEvent> &events) {
+        if (halted_ || !book_.halted()) return;
+        halted_ = true;
+        EngineMetrics::inc(Counter::Halts);
+        ExecutionSummary sum;
+        if (c.type != Command::Type::Controls) sum = ExecutionSummary{c.order.id, c.order.side};
+        events.push_back(EngineEvent{EngineEvent::Type::Halted, {}, sum, EngineStamps{c.ingress_tsc, 0, 0, 0}, {}});
+    }
+
+    void ack(const Command &c, AckStatus status, RejectReason reason = RejectReason::None, Qty filled = 0,
+             Qty leaves = 0) {
+        if (c.request) acks_.push_back(Ack{c.request, c.order.id, c.seq, status, reason, filled, leaves});
+    }
+
+    void warm_up(std::vector<Command> &batch, std::vector<EngineEvent> &events) {
+        StartupReport r;
+        if (warmup_.orders > 0) {
+            auto t0 = Clock::now();
+            std::size_t n = warmup_.orders;
+            EngineMetrics::prepare_thread();
+            FlightRecorder::prepare_thread();
+            TscClock::calibrate();
+            batch.reserve(std::max<std::size_t>(max_batch_.load(std::memory_order_relaxed), 1024));
+            events.reserve(batch.capacity());
+            book_.reserve(n);
+            inq_.prewarm(n);
+            outq_.prewarm(batch.capacity());
+            auto t1 = Clock::now();
+
+            // Fill both sides across `levels` prices, sweep the asks with
+            // one taker, cancel the bids: adds, crossing, level erase and
+            // cancel all run, and the book ends empty.
+            std::vector<Trade> trades;
+            trades.reserve(n);
+            Price levels = std::max<Price>(1, warmup_.levels);
+            OrderId id = kWarmupIdBit;
+            for (std::size_t i = 0; i < n; ++i) {
+                Price off = 1 + static_cast<Price>(i) % levels;
+                Side side = i % 2 ? Side::Buy : Side::Sell;
+                book_.add_order(Order{ id++, side, side == Side::Buy ? warmup_.base_price - off : warmup_.base_price + off,
+                                       1, {} }, trades);
+            }
+            book_.add_order(Order{ id++, Side::Buy, warmup_.base_price + levels, static_cast<Qty>(n), {} }, trades);
+            r.warm_trades = trades.size();
+            for (OrderId k = kWarmupIdBit; k < id; ++k) book_.cancel(k);
+            book_.set_price_controls(PriceControls{}); // forget the warm-up's last trade
+            r.warm_orders = n;
+            auto t2 = Clock::now();
+            r.prewarm = t1 - t0;
+            r.synthetic = t2 - t1;
+        }
+        r.total = Clock::now() - created_;
+        {
+            std::lock_guard<std::mutex> lk(ready_m_);
+            report_ = r;
+            ready_ = true;
+        }
+        ready_cv_.notify_all();
+    }
+
+    void take_instrument(std::vector<EngineEvent> &events) {
+        InstrumentSpec spec;
+        {
+            std::lock_guard<std::mutex> lk(pending_m_);
+            spec = pending_spec_;
+            spec_pending_.store(false, std::memory_order_relaxed);
+        }
+        rules_ = InstrumentRules(spec);
+        Command c = controls_command(spec.controls, spec.policy == MatchingPolicy::Auction);
+        sequence(c);
+        std::vector<Trade> none; // Controls never trades
+        book_.apply(c, none);
+        note_halt(c, events);
+    }
+
+    void publish_book_gauges() {
+        EngineMetrics::set(Gauge::BidLevels, static_cast<std::int64_t>(book_.bid_levels()));
+        EngineMetrics::set(Gauge::AskLevels, static_cast<std::int64_t>(book_.ask_levels()));
+        EngineMetrics::set(Gauge::RestingOrders, static_cast<std::int64_t>(book_.order_count()));
+    }
+
+    TimePoint created_ = Clock::now();
+    std::pmr::unsynchronized_pool_resource book_pool_; // worker thread only
+    std::pmr::unsynchronized_pool_resource inq_pool_;  // under inq_'s mutex
+    std::pmr::unsynchronized_pool_resource outq_pool_; // under outq_'s mutex
+    OrderBook book_;
+    ConcurrentQueue<Command> inq_;
+    ConcurrentQueue<EngineEvent> outq_;
+    SequencedSink on_sequenced_;
+    SeqNo seq_{0};
+    std::int64_t clock_ns_ = 0; // worker only; Clock::now() once per batch
+    std::atomic<std::size_t> max_batch_{64};
+    std::atomic<TradeReporting> reporting_{TradeReporting::Trades};
+    std::atomic<bool> depth_view_{false};
+    bool tracking_depth_ = false; // worker's view of depth_view_ for the current batch
+    bool halted_ = false;         // worker only; last halt state published
+    DepthPublisher depth_;
+    std::vector<Ack> acks_;            // current batch, worker only
+    std::mutex pending_m_;
+    InstrumentSpec pending_spec_;      // under pending_m_
+    std::atomic<bool> spec_pending_{false};
+    InstrumentRules rules_;            // worker only; default accepts any tick/lot
+    WarmupConfig warmup_;
+    std::mutex ready_m_;
+    std::condition_variable ready_cv_;
+    bool ready_ = false;               // under ready_m_
+    StartupReport report_;
+    std::atomic<bool> running_{false};
+    std::thread worker_;
+};
@@ -0,0 +1,179 @@
+//
+//  Backtest.h
+//  XChange
+//
+//  Created by Williams on 17/10/2026.
+//
+#pragma once
+#include "Journal.h"
+#include "OrderBook.h"
+
+#include <fcntl.h>
+#include <memory>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// --- Historical replay backtester ---
+//
+// Replays a recorded L3 event file (journal format: JournalFileHeader + raw
+// Commands) straight into an OrderBook on the calling thread: no queues, no
+// locks, one reused trade buffer. A Strategy sees every market event and
+// may submit/cancel its own simulated orders, which match against the
+// replayed book like any other order. Separate days run on separate cores.
+
+// Strategy order ids carry this bit so they never collide with market ids.
+inline constexpr OrderId kStrategyIdBit = OrderId{1} << 63;
+
+// Read-only mapping of a journal file as a Command array. Records are
+// neither checked nor trimmed: readers stop at the first seq 0 (zero
+// padding left by a crash) and verify journal_record_ok() themselves.
+class MappedJournal {
+public:
+    explicit MappedJournal(const std::string &path) {
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) throw std::runtime_error("backtest: cannot open " + path);
+        struct stat st{};
+        if (::fstat(fd, &st) != 0) {
+            ::close(fd);
+            throw std::runtime_error("backtest: cannot stat " + path);
+        }
+        size_ = static_cast<std::size_t>(st.st_size);
+        if (size_ < sizeof(JournalFileHeader)) {
+            ::close(fd);
+            throw std::runtime_error("backtest: truncated " + path);
+        }
+        void *p = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (p == MAP_FAILED) throw std::runtime_error("backtest: cannot map " + path);
+        base_ = static_cast<const char *>(p);
+        ::madvise(const_cast<char *>(base_), size_, MADV_SEQUENTIAL);
+        auto h = reinterpret_cast<const JournalFileHeader *>(base_);
+        if (std::memcmp(h->magic, JournalFileHeader{}.magic, 4) != 0
+            || h->version != JournalFileHeader{}.version || h->record_size != sizeof(Command)) {
+            ::munmap(const_cast<char *>(base_), size_);
+            throw std::runtime_error("backtest: bad header in " + path);
+        }
+    }
+    ~MappedJournal() { ::munmap(const_cast<char *>(base_), size_); }
+    MappedJournal(const MappedJournal &) = delete;
+    MappedJournal &operator=(const MappedJournal &) = delete;
+
+    const Command *begin() const { return reinterpret_cast<const Command *>(base_ + sizeof(JournalFileHeader)); }
+    const Command *end() const { return begin() + size(); }
+    std::size_t size() const { return (size_ - sizeof(JournalFileHeader)) / sizeof(Command); }
+
+private:
+    const char *base_ = nullptr;
+    std::size_t size_ = 0;
+};
+
+class BacktestContext;
+
+class Strategy {
+public:
+    virtual ~Strategy() = default;
+    // After each replayed market event has been applied.
+    virtual void on_event(const Command &, BacktestContext &) {}
+    // One of our orders traded; `as_maker` if it was resting.
+    virtual void on_fill(const Trade &, bool /*as_maker*/, BacktestContext &) {}
+};
+
+class BacktestContext {
+public:
+    // Submits a simulated order now; `id` gets kStrategyIdBit added.
+    void submit(OrderId id, Side side, Price price, Qty qty) {
+        Order o{id | kStrategyIdBit, side, price, qty, now_};
+        std::size_t first = scratch_.size();
+        book_.add_order(o, scratch_);
+        for (std::size_t i = first; i < scratch_.size(); ++i) {
+            ++taker_fills_;
+            strategy_.on_fill(scratch_[i], false, *this);
+        }
+        scratch_.resize(first);
+    }
+
+    bool cancel(OrderId id) { return book_.cancel(id | kStrategyIdBit); }
+
+    std::optional<Price> best_bid() const { return book_.best_bid(); }
+    std::optional<Price> best_ask() const { return book_.best_ask(); }
+    TimePoint now() const { return now_; }
+
+private:
+    friend class Backtester;
+    BacktestContext(OrderBook &book, Strategy &strategy) : book_(book), strategy_(strategy) {}
+
+    OrderBook &book_;
+    Strategy &strategy_;
+    TimePoint now_{};
+    std::vector<Trade> scratch_;
+    std::uint64_t taker_fills_ = 0;
+};
+
+struct BacktestResult {
+    std::string   file;
+    std::uint64_t events{};
+    std::uint64_t trades{};
+    std::uint64_t strategy_fills{};
+    double        seconds{};
+    double events_per_sec() const { return seconds > 0 ? static_cast<double>(events) / seconds : 0; }
+};
+
+class Backtester {
+public:
+    using StrategyFactory = std::function<std::unique_ptr<Strategy>()>;
+
+    // Replays one instrument's commands from one file through a fresh book;
+    // other instruments' records are skipped. Stops at the first zero-padded
+    // record and throws on a checksum mismatch, as JournalReader does.
+    static BacktestResult run(const std::string &path, Strategy &strategy, InstrumentId instrument = 0) {
+        MappedJournal events(path);
+        OrderBook book;
+        BacktestContext ctx(book, strategy);
+        std::vector<Trade> trades;
+        trades.reserve(1024);
+        BacktestResult r{path};
+        auto t0 = Clock::now();
+        for (const Command &c : events) {
+            if (c.seq == 0) break; // zero padding left by a crash
+            if (!journal_record_ok(c))
+                throw std::runtime_error("backtest: checksum mismatch at seq " + std::to_string(c.seq) + " of " + path);
+            if (c.instrument != instrument) continue;
+            ++r.events;
+            if (c.type != Command::Type::Controls && c.type != Command::Type::Resume) ctx.now_ = c.order.ts;
+            trades.clear();
+            book.apply(c, trades);
+            r.trades += trades.size();
+            for (auto const &t : trades) {
+                if (t.maker_id & kStrategyIdBit) {
+                    ++r.strategy_fills;
+                    strategy.on_fill(t, true, ctx);
+                }
+            }
+            strategy.on_event(c, ctx);
+        }
+        r.seconds = std::chrono::duration<double>(Clock::now() - t0).count();
+        r.strategy_fills += ctx.taker_fills_;
+        return r;
+    }
+
+    // One independent run per file (e.g. per day), `threads` at a time.
+    static std::vector<BacktestResult> run_parallel(const std::vector<std::string> &paths,
+                                                    const StrategyFactory &make,
+                                                    unsigned threads = std::thread::hardware_concurrency(),
+                                                    InstrumentId instrument = 0) {
+        std::vector<BacktestResult> results(paths.size());
+        std::atomic<std::size_t> next{0};
+        auto work = [&]{
+            for (std::size_t i; (i = next.fetch_add(1)) < paths.size();) {
+                auto strategy = make();
+                results[i] = run(paths[i], *strategy, instrument);
+            }
+        };
+        std::vector<std::thread> pool;
+        for (unsigned t = 1; t < std::max(1u, threads); ++t) pool.emplace_back(work);
+        work();
+        for (auto &t : pool) t.join();
+        return results;
+    }
+};
@@ -0,0 +1,115 @@
+//
+//  Crc32c.h
+//  XChange
+//
+//  Created by Williams on 17/10/2026.
+//
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+
+// Build with -DXCHANGE_CRC_SOFTWARE to force the table-driven path.
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__)) && !defined(XCHANGE_CRC_SOFTWARE)
+#define XCHANGE_CRC_SSE42 1
+#include <nmmintrin.h>
+#elif defined(__ARM_FEATURE_CRC32) && !defined(XCHANGE_CRC_SOFTWARE)
+#define XCHANGE_CRC_ARM 1
+#include <arm_acle.h>
+#endif
+
+// --- CRC32C (Castagnoli) for journal and book-file integrity ---
+//
+// x86-64 uses the SSE4.2 crc32 instruction, chosen at run time so the rest
+// of the build needs no -msse4.2; ARMv8 uses its CRC32C instructions when
+// the compiler targets them. Anywhere else, and on x86 CPUs without SSE4.2,
+// a slice-by-8 table does the same sum. All three give identical results,
+// so files move freely between machines.
+
+namespace crc32c_detail {
+
+inline constexpr std::uint32_t kPoly = 0x82f63b78u; // reflected
+
+using Tables = std::array<std::array<std::uint32_t, 256>, 8>;
+
+constexpr Tables make_tables() {
+    Tables t{};
+    for (std::uint32_t i = 0; i < 256; ++i) {
+        std::uint32_t c = i;
+        for (int k = 0; k < 8; ++k) c = c & 1 ? (c >> 1) ^ kPoly : c >> 1;
+        t[0][i] = c;
+    }
+    for (std::size_t s = 1; s < 8; ++s)
+        for (std::size_t i = 0; i < 256; ++i) t[s][i] = (t[s - 1][i] >> 8) ^ t[0][t[s - 1][i] & 0xff];
+    return t;
+}
+
+inline constexpr Tables kTables = make_tables();
+
+inline std::uint32_t software(std::uint32_t crc, const unsigned char *p, std::size_t n) {
+    for (; n >= 8; p += 8, n -= 8) {
+        std::uint64_t w;
+        std::memcpy(&w, p, 8);
+        w ^= crc;
+        crc = kTables[7][w & 0xff] ^ kTables[6][(w >> 8) & 0xff] ^ kTables[5][(w >> 16) & 0xff]
+            ^ kTables[4][(w >> 24) & 0xff] ^ kTables[3][(w >> 32) & 0xff] ^ kTables[2][(w >> 40) & 0xff]
+            ^ kTables[1][(w >> 48) & 0xff] ^ kTables[0][w >> 56];
+    }
+    for (; n > 0; ++p, --n) crc = (crc >> 8) ^ kTables[0][(crc ^ *p) & 0xff];
+    return crc;
+}
+
+#if defined(XCHANGE_CRC_SSE42)
+__attribute__((target("sse4.2"))) inline std::uint32_t hardware(std::uint32_t crc, const unsigned char *p,
+                                                                 std::size_t n) {
+    std::uint64_t c = crc;
+    for (; n >= 8; p += 8, n -= 8) {
+        std::uint64_t w;
+        std::memcpy(&w, p, 8);
+        c = _mm_crc32_u64(c, w);
+    }
+    crc = static_cast<std::uint32_t>(c);
+    for (; n > 0; ++p, --n) crc = _mm_crc32_u8(crc, *p);
+    return crc;
+}
+
+inline bool have_hardware() {
+    static const bool yes = __builtin_cpu_supports("sse4.2");
+    return yes;
+}
+#elif defined(XCHANGE_CRC_ARM)
+inline std::uint32_t hardware(std::uint32_t crc, const unsigned char *p, std::size_t n) {
+    for (; n >= 8; p += 8, n -= 8) {
+        std::uint64_t w;
+        std::memcpy(&w, p, 8);
+        crc = __crc32cd(crc, w);
+    }
+    for (; n > 0; ++p, --n) crc = __crc32cb(crc, *p);
+    return crc;
+}
+
+inline bool have_hardware() { return true; }
+#else
+inline bool have_hardware() { return false; }
+#endif
+
+} // namespace crc32c_detail
+
+// CRC32C of [p, p + n); pass a previous result as `crc` to continue it.
+inline std::uint32_t crc32c(const void *p, std::size_t n, std::uint32_t crc = 0) {
+    auto b = static_cast<const unsigned char *>(p);
+#if defined(XCHANGE_CRC_SSE42) || defined(XCHANGE_CRC_ARM)
+    if (crc32c_detail::have_hardware()) return ~crc32c_detail::hardware(~crc, b, n);
+#endif
+    return ~crc32c_detail::software(~crc, b, n);
+}
+
+inline const char *crc32c_backend() {
+#if defined(XCHANGE_CRC_SSE42)
+    if (crc32c_detail::have_hardware()) return "sse4.2";
+#elif defined(XCHANGE_CRC_ARM)
+    return "armv8-crc";
+#endif
+    return "software";
+}
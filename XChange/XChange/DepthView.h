@@ -0,0 +1,243 @@
+//
+//  DepthView.h
+//  XChange
+//
+//  Created by Williams on 17/10/2026.
+//
+#pragma once
+#include "OrderBook.h"
+
+#include <algorithm>
+#include <memory>
+#include <stdexcept>
+
+// --- Published depth: immutable snapshots, RCU with epoch reclamation ---
+//
+// The matcher keeps an aggregated (price -> qty, orders) mirror of the book,
+// recomputes only the levels a batch touched, and publishes a fresh
+// immutable DepthSnapshot by swapping one atomic pointer. Readers pin an
+// epoch, load the pointer and read at leisure; nothing they see is ever
+// modified. The old snapshot is retired with the epoch it was replaced in
+// and freed once every pinned reader has moved past it. The matcher never
+// waits on a reader: a slow reader only delays reclamation.
+
+// Latest-version publisher of immutable T. One writer; up to kMaxReaders
+// registered readers at a time.
+template <typename T>
+class RcuPublished {
+public:
+    static constexpr std::size_t kMaxReaders = 64;
+
+    class Pin;
+
+    // A registered reader owns one epoch slot. One Pin at a time per Reader.
+    class Reader {
+    public:
+        Reader(Reader &&o) noexcept : owner_(o.owner_), slot_(o.slot_) { o.owner_ = nullptr; }
+        Reader(const Reader &) = delete;
+        Reader &operator=(const Reader &) = delete;
+        ~Reader() {
+            if (owner_) owner_->slots_[slot_].used.store(false, std::memory_order_release);
+        }
+
+        // Holds the current version alive until the Pin goes away.
+        Pin pin() const {
+            auto &s = owner_->slots_[slot_];
+            s.epoch.store(owner_->epoch_.load(std::memory_order_relaxed), std::memory_order_seq_cst);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            return Pin(s.epoch, owner_->current_.load(std::memory_order_seq_cst));
+        }
+
+    private:
+        friend class RcuPublished;
+        Reader(RcuPublished *owner, std::size_t slot) : owner_(owner), slot_(slot) {}
+        RcuPublished *owner_;
+        std::size_t slot_;
+    };
+
+    class Pin {
+    public:
+        Pin(Pin &&o) noexcept : epoch_(o.epoch_), value_(o.value_) { o.epoch_ = nullptr; }
+        Pin(const Pin &) = delete;
+        Pin &operator=(const Pin &) = delete;
+        ~Pin() {
+            if (epoch_) epoch_->store(0, std::memory_order_release);
+        }
+
+        const T *get() const { return value_; } // null before the first publish
+        const T *operator->() const { return value_; }
+        const T &operator*() const { return *value_; }
+        explicit operator bool() const { return value_ != nullptr; }
+
+    private:
+        friend class Reader;
+        Pin(std::atomic<std::uint64_t> &epoch, const T *value) : epoch_(&epoch), value_(value) {}
+        std::atomic<std::uint64_t> *epoch_;
+        const T *value_;
+    };
+
+    RcuPublished() = default;
+    RcuPublished(const RcuPublished &) = delete;
+    RcuPublished &operator=(const RcuPublished &) = delete;
+    ~RcuPublished() { // readers must be gone
+        delete current_.load(std::memory_order_relaxed);
+        for (auto &r : retired_) delete r.value;
+    }
+
+    // Throws if all slots are taken.
+    Reader reader() {
+        for (std::size_t i = 0; i < kMaxReaders; ++i) {
+            bool expected = false;
+            if (slots_[i].used.compare_exchange_strong(expected, true, std::memory_order_acq_rel))
+                return Reader(this, i);
+        }
+        throw std::runtime_error("rcu: no free reader slot");
+    }
+
+    // Writer only. Swaps in `next`, retires the previous version and frees
+    // whatever no pinned reader can still see.
+    void publish(std::unique_ptr<T> next) {
+        const T *prev = current_.exchange(next.release(), std::memory_order_seq_cst);
+        std::uint64_t e = epoch_.fetch_add(1, std::memory_order_seq_cst);
+        if (prev) retired_.push_back({prev, e});
+        reclaim();
+    }
+
+    // Writer only. Versions retired but still pinned by some reader.
+    std::size_t retired() const { return retired_.size(); }
+
+private:
+    struct alignas(64) Slot {
+        std::atomic<std::uint64_t> epoch{0}; // 0 = not pinned
+        std::atomic<bool> used{false};
+    };
+
+    struct Retired {
+        const T *value;
+        std::uint64_t epoch; // replaced while the global epoch was this
+    };
+
+    // A reader pinned at epoch p loaded the pointer after the global epoch
+    // reached p, so it can only hold versions retired at epoch >= p.
+    void reclaim() {
+        std::uint64_t oldest = ~std::uint64_t{0};
+        for (auto &s : slots_) {
+            std::uint64_t p = s.epoch.load(std::memory_order_seq_cst);
+            if (p != 0 && p < oldest) oldest = p;
+        }
+        std::size_t kept = 0;
+        for (auto &r : retired_) {
+            if (r.epoch < oldest) delete r.value;
+            else retired_[kept++] = r;
+        }
+        retired_.resize(kept);
+    }
+
+    std::atomic<const T *> current_{nullptr};
+    std::atomic<std::uint64_t> epoch_{1};
+    Slot slots_[kMaxReaders];
+    std::vector<Retired> retired_; // writer only
+};
+
+struct DepthLevel {
+    Price         price{};
+    Qty           qty{};
+    std::uint32_t orders{};
+};
+
+struct DepthSnapshot {
+    SeqNo                   seq{};  // last command applied
+    std::vector<DepthLevel> bids;   // best (highest) first
+    std::vector<DepthLevel> asks;   // best (lowest) first
+};
+
+// Matcher side: mirror of the book's levels, patched per batch.
+class DepthPublisher {
+public:
+    using Reader = RcuPublished<DepthSnapshot>::Reader;
+
+    // Level (side, price) may have changed in the current batch.
+    void touch(Side side, Price price) { touch(side, price, price); }
+
+    // Every level between `a` and `b` inclusive may have changed, e.g. the
+    // ones a sweep walked through (ExecutionSummary first/last price).
+    void touch(Side side, Price a, Price b) {
+        Dirty d{side, std::min(a, b), std::max(a, b)};
+        if (dirty_.empty() || dirty_.back().side != side || dirty_.back().lo != d.lo || dirty_.back().hi != d.hi)
+            dirty_.push_back(d);
+    }
+
+    // Recomputes the touched levels from `book` and publishes a snapshot if
+    // anything changed. The first call (or one after reset()) mirrors the
+    // whole book.
+    void update(const OrderBook &book, SeqNo seq) {
+        if (!synced_) {
+            bids_.clear();
+            asks_.clear();
+            book.for_each_resting([&](Side s, Price px, OrderId, Qty q) {
+                DepthLevel &l = s == Side::Buy ? bids_[px] : asks_[px];
+                l.price = px;
+                l.qty += q;
+                ++l.orders;
+            });
+            synced_ = true;
+        } else if (dirty_.empty()) {
+            return;
+        } else {
+            for (auto const &d : dirty_) {
+                if (d.side == Side::Buy) refresh(book, d, bids_);
+                else refresh(book, d, asks_);
+            }
+        }
+        dirty_.clear();
+
+        auto snap = std::make_unique<DepthSnapshot>();
+        snap->seq = seq;
+        snap->bids.reserve(bids_.size());
+        snap->asks.reserve(asks_.size());
+        for (auto const &[px, l] : bids_) snap->bids.push_back(l);
+        for (auto const &[px, l] : asks_) snap->asks.push_back(l);
+        published_.publish(std::move(snap));
+    }
+
+    // Forget the mirror; the next update() rebuilds it in full.
+    void reset() {
+        synced_ = false;
+        dirty_.clear();
+    }
+
+    Reader reader() { return published_.reader(); }
+
+private:
+    struct Dirty {
+        Side  side;
+        Price lo, hi;
+    };
+
+    // Re-reads both ends of the range, plus every mirrored level inside it:
+    // a level can only appear inside a range through its own touch().
+    template <typename Levels>
+    static void refresh(const OrderBook &book, const Dirty &d, Levels &levels) {
+        auto reread = [&](Price px) {
+            DepthLevel l{px};
+            book.for_each_at_level(d.side, px, [&](OrderId, Qty q) { l.qty += q; ++l.orders; });
+            if (l.orders == 0) levels.erase(px);
+            else levels[px] = l;
+        };
+        reread(d.lo);
+        if (d.hi == d.lo) return;
+        auto first = levels.upper_bound(d.side == Side::Buy ? d.hi : d.lo); // strictly inside, map order
+        while (first != levels.end() && first->first > d.lo && first->first < d.hi) {
+            Price px = first->first;
+            ++first;
+            reread(px);
+        }
+        reread(d.hi);
+    }
+
+    std::map<Price, DepthLevel, std::greater<>> bids_;
+    std::map<Price, DepthLevel> asks_;
+    std::vector<Dirty> dirty_;
+    bool synced_ = false;
+    RcuPublished<DepthSnapshot> published_;
+};
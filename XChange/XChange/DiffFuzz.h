@@ -0,0 +1,241 @@
+//
+//  DiffFuzz.h
+//  XChange
+//
+//  Created by Williams on 17/10/2026.
+//
+#pragma once
+#include "OrderBook.h"
+
+#include <memory>
+#include <random>
+#include <sstream>
+
+// --- Differential fuzzing: optimized books vs the reference OrderBook ---
+//
+// The same op stream runs through a plain OrderBook (map/deque, the
+// reference) and every registered variant. After each op the trades, the
+// BBO and a hash of the full resting state must agree. A failing stream is
+// shrunk by deleting chunks while it keeps failing.
+//
+// To keep millions of ops per second, each step compares the levels the op
+// could have changed (its own price plus every level it traded against);
+// the whole book is compared every kFullCheckEvery steps and at the end.
+
+struct FuzzOp {
+    bool    cancel{};
+    Side    side{};
+    Price   price{};
+    Qty     qty{};
+    OrderId id{};  // new order id, or the id to cancel
+};
+
+// Type-erased book under test.
+class FuzzBook {
+public:
+    virtual ~FuzzBook() = default;
+    virtual std::vector<Trade> add_order(const Order &o) = 0;
+    virtual bool cancel(OrderId id) = 0;
+    virtual std::optional<Price> best_bid() const = 0;
+    virtual std::optional<Price> best_ask() const = 0;
+    virtual std::uint64_t state_hash() const = 0;
+    virtual std::uint64_t level_hash(Side s, Price px) const = 0;
+    virtual std::string dump() const = 0;
+};
+
+template <typename Book>
+class FuzzAdapter : public FuzzBook {
+public:
+    template <typename... Args>
+    explicit FuzzAdapter(Args &&...args) : book_(std::forward<Args>(args)...) {}
+
+    std::vector<Trade> add_order(const Order &o) override { return book_.add_order(o); }
+    bool cancel(OrderId id) override { return book_.cancel(id); }
+    std::optional<Price> best_bid() const override { return book_.best_bid(); }
+    std::optional<Price> best_ask() const override { return book_.best_ask(); }
+
+    std::uint64_t state_hash() const override {
+        std::uint64_t h = 0xcbf29ce484222325ull;
+        book_.for_each_resting([&](Side s, Price px, OrderId id, Qty q){ mix(h, s, px, id, q); });
+        return h;
+    }
+
+    std::uint64_t level_hash(Side s, Price px) const override {
+        std::uint64_t h = 0xcbf29ce484222325ull;
+        book_.for_each_at_level(s, px, [&](OrderId id, Qty q){ mix(h, s, px, id, q); });
+        return h;
+    }
+
+    std::string dump() const override {
+        std::ostringstream os;
+        book_.print_book(os);
+        return os.str();
+    }
+
+    Book &book() { return book_; }
+
+private:
+    static void mix(std::uint64_t &h, Side s, Price px, OrderId id, Qty q) {
+        for (std::uint64_t v : {static_cast<std::uint64_t>(s), static_cast<std::uint64_t>(px),
+                                id, static_cast<std::uint64_t>(q)})
+            h = (h ^ v) * 0x100000001b3ull;
+    }
+
+    Book book_;
+};
+
+class DifferentialFuzzer {
+public:
+    static constexpr std::size_t kFullCheckEvery = 64;
+
+    using Factory = std::function<std::unique_ptr<FuzzBook>()>;
+
+    void add_variant(std::string name, Factory make) {
+        variants_.push_back({std::move(name), std::move(make)});
+    }
+
+    // Random stream: prices in [100 - band, 100 + band]; cancels pick a
+    // random earlier id (some already filled), which keeps the book small.
+    static std::vector<FuzzOp> random_ops(std::uint64_t seed, std::size_t n, Price band = 8) {
+        std::mt19937_64 rng(seed);
+        std::vector<FuzzOp> ops(n);
+        std::vector<OrderId> issued;
+        OrderId next = 1;
+        for (auto &op : ops) {
+            std::uint64_t r = rng();
+            op.cancel = (r & 7) < 3 && !issued.empty();
+            if (op.cancel) {
+                std::size_t k = (r >> 8) % issued.size();
+                op.id = issued[k];
+                issued[k] = issued.back();
+                issued.pop_back();
+                continue;
+            }
+            op.id = next++;
+            issued.push_back(op.id);
+            op.side = (r >> 3) & 1 ? Side::Sell : Side::Buy;
+            op.price = 100 - band + static_cast<Price>((r >> 16) % static_cast<std::uint64_t>(2 * band + 1));
+            op.qty = 1 + static_cast<Qty>((r >> 32) % 20);
+        }
+        return ops;
+    }
+
+    // libFuzzer input: 4 bytes per op.
+    static std::vector<FuzzOp> decode_ops(const std::uint8_t *data, std::size_t size) {
+        std::vector<FuzzOp> ops;
+        ops.reserve(size / 4);
+        OrderId next = 1;
+        for (std::size_t i = 0; i + 4 <= size; i += 4) {
+            FuzzOp op;
+            op.cancel = (data[i] & 3) == 0;
+            if (op.cancel) {
+                op.id = next > data[i + 1] ? next - data[i + 1] : 1;
+            } else {
+                op.id = next++;
+                op.side = (data[i] & 4) ? Side::Sell : Side::Buy;
+                op.price = 92 + data[i + 2] % 17;
+                op.qty = 1 + data[i + 3] % 32;
+            }
+            ops.push_back(op);
+        }
+        return ops;
+    }
+
+    struct Failure {
+        std::size_t step{};   // index of the first divergent op
+        std::string variant;
+        std::string detail;
+    };
+
+    // Runs `ops` through the reference and every variant.
+    std::optional<Failure> run(const std::vector<FuzzOp> &ops) const {
+        FuzzAdapter<OrderBook> ref;
+        std::vector<std::unique_ptr<FuzzBook>> books;
+        books.reserve(variants_.size());
+        for (auto const &v : variants_) books.push_back(v.make());
+
+        std::unordered_map<OrderId, std::pair<Side, Price>> placed; // for cancels' levels
+        std::vector<std::pair<Side, Price>> touched;
+        for (std::size_t i = 0; i < ops.size(); ++i) {
+            const FuzzOp &op = ops[i];
+            Order o{op.id, op.side, op.price, op.qty, {}};
+            std::vector<Trade> want;
+            bool want_hit = false;
+            touched.clear();
+            if (op.cancel) {
+                want_hit = ref.cancel(op.id);
+                if (auto it = placed.find(op.id); it != placed.end()) touched.push_back(it->second);
+            } else {
+                want = ref.add_order(o);
+                placed[op.id] = {op.side, op.price};
+                touched.emplace_back(op.side, op.price);
+                Side maker = op.side == Side::Buy ? Side::Sell : Side::Buy;
+                for (auto const &t : want)
+                    if (touched.back() != std::pair{maker, t.price}) touched.emplace_back(maker, t.price);
+            }
+            bool full = (i + 1) % kFullCheckEvery == 0 || i + 1 == ops.size();
+            std::uint64_t want_hash = full ? ref.state_hash() : 0;
+
+            for (std::size_t v = 0; v < books.size(); ++v) {
+                FuzzBook &b = *books[v];
+                const char *what = nullptr;
+                if (op.cancel) {
+                    if (b.cancel(op.id) != want_hit) what = "cancel result";
+                } else {
+                    auto got = b.add_order(o);
+                    if (got.size() != want.size()
+                        || !std::equal(got.begin(), got.end(), want.begin(), [](const Trade &x, const Trade &y) {
+                               return x.maker_id == y.maker_id && x.taker_id == y.taker_id
+                                   && x.price == y.price && x.qty == y.qty; }))
+                        what = "trades";
+                }
+                if (!what && (b.best_bid() != ref.best_bid() || b.best_ask() != ref.best_ask())) what = "BBO";
+                for (auto const &[s, px] : touched)
+                    if (!what && b.level_hash(s, px) != ref.level_hash(s, px)) what = "touched level";
+                if (!what && full && b.state_hash() != want_hash) what = "book state";
+                if (what) {
+                    return Failure{i, variants_[v].name,
+                                   std::string(what) + " differ\n--- reference" + ref.dump()
+                                   + "--- " + variants_[v].name + b.dump()};
+                }
+            }
+        }
+        return std::nullopt;
+    }
+
+    // Deletes ever smaller chunks of a failing stream while it still fails
+    // (ddmin-style); returns the smallest failing stream found.
+    std::vector<FuzzOp> shrink(std::vector<FuzzOp> ops) const {
+        if (auto f = run(ops)) ops.resize(f->step + 1); // nothing after the divergence matters
+        for (std::size_t chunk = ops.size() / 2; chunk >= 1; chunk /= 2) {
+            for (std::size_t start = 0; start + chunk <= ops.size();) {
+                std::vector<FuzzOp> cand;
+                cand.reserve(ops.size() - chunk);
+                cand.insert(cand.end(), ops.begin(), ops.begin() + static_cast<std::ptrdiff_t>(start));
+                cand.insert(cand.end(), ops.begin() + static_cast<std::ptrdiff_t>(start + chunk), ops.end());
+                if (auto f = run(cand)) {
+                    cand.resize(f->step + 1);
+                    ops = std::move(cand);
+                } else {
+                    start += chunk;
+                }
+            }
+        }
+        return ops;
+    }
+
+    static void print_ops(const std::vector<FuzzOp> &ops, std::ostream &os) {
+        for (auto const &op : ops) {
+            if (op.cancel) os << "  cancel " << op.id << "\n";
+            else os << "  add " << op.id << (op.side == Side::Buy ? " BUY " : " SELL ")
+                    << op.qty << "@" << op.price << "\n";
+        }
+    }
+
+private:
+    struct Variant {
+        std::string name;
+        Factory make;
+    };
+    std::vector<Variant> variants_;
+};
@@ -0,0 +1,422 @@
+//
+//  Fix.h
+//  XChange
+//
+//  Created by Williams on 17/10/2026.
+//
+#pragma once
+#include "AsyncOrderBook.h"
+
+#include <cstring>
+#include <memory>
+
+// Build with -DXCHANGE_FIX_SCALAR to force the portable scan.
+#if defined(__AVX2__) && !defined(XCHANGE_FIX_SCALAR)
+#define XCHANGE_FIX_AVX2 1
+#include <immintrin.h>
+#elif defined(__SSE2__) && defined(__x86_64__) && !defined(XCHANGE_FIX_SCALAR)
+#define XCHANGE_FIX_SSE2 1
+#include <emmintrin.h>
+#endif
+
+// --- FIX 4.4 order entry: framing, SIMD field scan, allocation-free decode ---
+//
+// A FixSession takes raw bytes off a connection, frames whole messages by
+// BodyLength(9), checks CheckSum(10) and MsgSeqNum(34), and decodes
+// NewOrderSingle (D), OrderCancelRequest (F) and OrderCancelReplaceRequest
+// (G) into a FixRequest; route() hands that to the engine as submit(),
+// cancel() or replace(). MsgSeqNum becomes the RequestId, so every Ack maps
+// straight back to the message that caused it.
+//
+// SOH and '=' are located 64 bytes at a time as two bitmasks (AVX2 or SSE2
+// compares, a byte loop elsewhere) and fields are walked off the set bits;
+// the checksum is a SAD sum over the same registers. Numbers are parsed in
+// place. ClOrdID/OrigClOrdID must be numeric: they are the order ids.
+// Prices are decimals scaled to ticks by `price_decimals`. Nothing is
+// allocated per message: the session buffers partial reads in one fixed
+// array and the decoder fills the caller's FixRequest.
+
+namespace fix_detail {
+
+constexpr char kSoh = '\x01';
+
+#if defined(XCHANGE_FIX_AVX2)
+constexpr const char *kScanPath = "avx2";
+#elif defined(XCHANGE_FIX_SSE2)
+constexpr const char *kScanPath = "sse2";
+#else
+constexpr const char *kScanPath = "scalar";
+#endif
+
+// Bit i of `soh` / `eq` is set if p[i] is SOH / '='; n <= 64.
+inline void scalar_masks(const char *p, std::size_t n, std::uint64_t &soh, std::uint64_t &eq) {
+    soh = eq = 0;
+    for (std::size_t i = 0; i < n; ++i) {
+        soh |= std::uint64_t{p[i] == kSoh} << i;
+        eq |= std::uint64_t{p[i] == '='} << i;
+    }
+}
+
+// Same for a full 64-byte block.
+inline void masks64(const char *p, std::uint64_t &soh, std::uint64_t &eq) {
+#if defined(XCHANGE_FIX_AVX2)
+    const __m256i s = _mm256_set1_epi8(kSoh), e = _mm256_set1_epi8('=');
+    __m256i lo = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+    __m256i hi = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p + 32));
+    auto bits = [](__m256i v, __m256i c) {
+        return std::uint64_t{static_cast<std::uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, c)))};
+    };
+    soh = bits(lo, s) | bits(hi, s) << 32;
+    eq = bits(lo, e) | bits(hi, e) << 32;
+#elif defined(XCHANGE_FIX_SSE2)
+    const __m128i s = _mm_set1_epi8(kSoh), e = _mm_set1_epi8('=');
+    soh = eq = 0;
+    for (int i = 0; i < 4; ++i) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + 16 * i));
+        soh |= std::uint64_t{static_cast<std::uint16_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(v, s)))} << (16 * i);
+        eq |= std::uint64_t{static_cast<std::uint16_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(v, e)))} << (16 * i);
+    }
+#else
+    scalar_masks(p, 64, soh, eq);
+#endif
+}
+
+// Sum of the bytes mod 256 (the CheckSum(10) value).
+inline unsigned checksum(const char *p, std::size_t n) {
+    std::uint64_t sum = 0;
+    std::size_t i = 0;
+#if defined(XCHANGE_FIX_AVX2)
+    __m256i acc = _mm256_setzero_si256();
+    for (; i + 32 <= n; i += 32)
+        acc = _mm256_add_epi64(acc, _mm256_sad_epu8(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(p + i)),
+                                                    _mm256_setzero_si256()));
+    alignas(32) std::uint64_t lanes[4];
+    _mm256_store_si256(reinterpret_cast<__m256i *>(lanes), acc);
+    sum = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+#elif defined(XCHANGE_FIX_SSE2)
+    __m128i acc = _mm_setzero_si128();
+    for (; i + 16 <= n; i += 16)
+        acc = _mm_add_epi64(acc, _mm_sad_epu8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(p + i)),
+                                              _mm_setzero_si128()));
+    sum = static_cast<std::uint64_t>(_mm_cvtsi128_si64(acc) + _mm_cvtsi128_si64(_mm_unpackhi_epi64(acc, acc)));
+#endif
+    for (; i < n; ++i) sum += static_cast<unsigned char>(p[i]);
+    return static_cast<unsigned>(sum % 256);
+}
+
+// Digits only; false if empty, not all digits, or over 19 digits.
+inline bool parse_uint(const char *p, std::size_t n, std::uint64_t &out) {
+    if (n == 0 || n > 19) return false;
+    std::uint64_t v = 0;
+    for (std::size_t i = 0; i < n; ++i) {
+        unsigned d = static_cast<unsigned char>(p[i]) - unsigned{'0'};
+        if (d > 9) return false;
+        v = v * 10 + d;
+    }
+    out = v;
+    return true;
+}
+
+// "[-]int[.frac]" as an integer count of 10^-decimals. Fraction digits past
+// `decimals` must be zeros.
+inline bool parse_price(const char *p, std::size_t n, int decimals, std::int64_t &out) {
+    bool neg = n > 0 && p[0] == '-';
+    if (neg) { ++p; --n; }
+    std::size_t dot = 0;
+    while (dot < n && p[dot] != '.') ++dot;
+    std::uint64_t ip = 0;
+    if (dot + static_cast<std::size_t>(decimals) > 18 || !parse_uint(p, dot, ip)) return false;
+    std::uint64_t v = ip;
+    std::size_t f = dot + 1; // first fraction digit, if any
+    for (int k = 0; k < decimals; ++k, ++f) {
+        unsigned d = f < n ? static_cast<unsigned char>(p[f]) - unsigned{'0'} : 0;
+        if (d > 9) return false;
+        v = v * 10 + d;
+    }
+    for (; f < n; ++f)
+        if (p[f] != '0') return false;
+    if (dot + 1 == n) return false; // "12."
+    out = neg ? -static_cast<std::int64_t>(v) : static_cast<std::int64_t>(v);
+    return true;
+}
+
+// Calls f(tag, value, len) for each tag=value<SOH> in [p, p + n); stops
+// early when f returns false. False if a field is malformed or the range
+// does not end on SOH. '=' inside a value is allowed.
+template <typename F>
+bool for_each_field(const char *p, std::size_t n, F &&f) {
+    std::size_t start = 0, eq_at = 0;
+    bool want_eq = true;
+    for (std::size_t base = 0; base < n; base += 64) {
+        std::uint64_t soh, eq;
+        if (n - base >= 64) masks64(p + base, soh, eq);
+        else scalar_masks(p + base, n - base, soh, eq);
+        std::uint64_t live = ~std::uint64_t{0}; // bits of this block not yet walked past
+        for (;;) {
+            if (want_eq) {
+                std::uint64_t e = eq & live, s = soh & live;
+                if (!e) {
+                    if (s) return false; // field with no '='
+                    break;
+                }
+                unsigned i = static_cast<unsigned>(__builtin_ctzll(e));
+                if (s & ((std::uint64_t{1} << i) - 1)) return false;
+                eq_at = base + i;
+                want_eq = false;
+                live &= ~((std::uint64_t{2} << i) - 1);
+            }
+            std::uint64_t s = soh & live; // '=' inside the value is skipped
+            if (!s) break;
+            unsigned i = static_cast<unsigned>(__builtin_ctzll(s));
+            std::uint64_t tag;
+            if (!parse_uint(p + start, eq_at - start, tag) || tag > 0xffffffff) return false;
+            if (!f(static_cast<std::uint32_t>(tag), p + eq_at + 1, base + i - eq_at - 1)) return true;
+            start = base + i + 1;
+            want_eq = true;
+            live &= ~((std::uint64_t{2} << i) - 1);
+        }
+    }
+    return want_eq && start == n;
+}
+
+} // namespace fix_detail
+
+enum class FixStatus : std::uint8_t {
+    Ok,
+    Incomplete,   // need more bytes
+    BadFrame,     // not "8=FIX.4.4<SOH>9=<len><SOH>": the stream cannot be resynchronised
+    BadChecksum,
+    Malformed,    // field syntax, or a value that does not parse
+    MissingField, // a required tag is absent
+    Unsupported,  // MsgType, Side, OrdType or MaxFloor this front end does not take
+};
+
+struct FixRequest {
+    // Admin: Heartbeat, TestRequest, ResendRequest, Reject, SequenceReset,
+    // Logout, Logon; only the session looks at these.
+    enum class Kind : std::uint8_t { NewOrder, Cancel, Replace, Admin };
+    Kind          kind{};
+    char          msg_type{}; // MsgType(35); all the types taken are one char
+    std::uint64_t seq{};      // MsgSeqNum(34)
+    Order         order{};    // NewOrder, Replace; ts is left for the router
+    OrderId       orig{};     // OrigClOrdID(41) for Cancel, Replace
+    Display       display{};  // MaxFloor(111)=0 makes a NewOrder/Replace hidden
+};
+
+class FixParser {
+public:
+    static constexpr std::size_t kMaxBody = 4096;
+
+    explicit FixParser(int price_decimals = 0) : decimals_(price_decimals) {}
+
+    // Frames and decodes the message at the front of [p, p + n). `used` is
+    // its full length once framed (so the caller can skip a bad message),
+    // 0 for Incomplete and BadFrame.
+    FixStatus parse(const char *p, std::size_t n, FixRequest &out, std::size_t &used) const {
+        static constexpr char kBegin[] = "8=FIX.4.4\x01" "9=";
+        constexpr std::size_t kBeginLen = sizeof(kBegin) - 1;
+        used = 0;
+        if (std::memcmp(p, kBegin, std::min(n, kBeginLen)) != 0) return FixStatus::BadFrame;
+        std::size_t len_end = kBeginLen; // SOH after the BodyLength digits
+        while (len_end < n && p[len_end] != fix_detail::kSoh) {
+            if (len_end - kBeginLen > 5) return FixStatus::BadFrame;
+            ++len_end;
+        }
+        if (len_end >= n) return FixStatus::Incomplete;
+        std::uint64_t body = 0;
+        if (!fix_detail::parse_uint(p + kBeginLen, len_end - kBeginLen, body) || body > kMaxBody)
+            return FixStatus::BadFrame;
+        std::size_t trailer = len_end + 1 + body; // "10=nnn<SOH>"
+        if (n < trailer + 7) return FixStatus::Incomplete;
+        if (std::memcmp(p + trailer, "10=", 3) != 0 || p[trailer + 6] != fix_detail::kSoh) return FixStatus::BadFrame;
+        used = trailer + 7;
+        std::uint64_t sum = 0;
+        if (!fix_detail::parse_uint(p + trailer + 3, 3, sum)) return FixStatus::Malformed;
+        if (sum != fix_detail::checksum(p, trailer)) return FixStatus::BadChecksum;
+        return decode(p + len_end + 1, body, out);
+    }
+
+private:
+    enum : std::uint32_t {
+        kSeenType = 1, kSeenSeq = 2, kSeenId = 4, kSeenOrig = 8, kSeenSide = 16, kSeenQty = 32, kSeenPrice = 64,
+        kSeenOrdType = 128,
+    };
+
+    FixStatus decode(const char *p, std::size_t n, FixRequest &out) const {
+        out = FixRequest{};
+        std::uint32_t seen = 0;
+        FixStatus st = FixStatus::Ok;
+        auto fail = [&](FixStatus s) { st = s; return false; };
+        bool well_formed = fix_detail::for_each_field(p, n, [&](std::uint32_t tag, const char *v, std::size_t len) {
+            std::uint64_t u = 0;
+            switch (tag) {
+                case 35:
+                    if (len != 1) return fail(FixStatus::Unsupported);
+                    out.msg_type = v[0];
+                    seen |= kSeenType;
+                    break;
+                case 34:
+                    if (!fix_detail::parse_uint(v, len, out.seq)) return fail(FixStatus::Malformed);
+                    seen |= kSeenSeq;
+                    break;
+                case 11:
+                    if (!fix_detail::parse_uint(v, len, out.order.id)) return fail(FixStatus::Malformed);
+                    seen |= kSeenId;
+                    break;
+                case 41:
+                    if (!fix_detail::parse_uint(v, len, out.orig)) return fail(FixStatus::Malformed);
+                    seen |= kSeenOrig;
+                    break;
+                case 54:
+                    if (len != 1 || (v[0] != '1' && v[0] != '2')) return fail(FixStatus::Unsupported);
+                    out.order.side = v[0] == '1' ? Side::Buy : Side::Sell;
+                    seen |= kSeenSide;
+                    break;
+                case 38:
+                    if (!fix_detail::parse_uint(v, len, u) || u == 0 || u > std::uint64_t{std::numeric_limits<Qty>::max()})
+                        return fail(FixStatus::Malformed);
+                    out.order.qty = static_cast<Qty>(u);
+                    seen |= kSeenQty;
+                    break;
+                case 44:
+                    if (!fix_detail::parse_price(v, len, decimals_, out.order.price)) return fail(FixStatus::Malformed);
+                    seen |= kSeenPrice;
+                    break;
+                case 40:
+                    if (len != 1 || v[0] != '2') return fail(FixStatus::Unsupported); // limit only
+                    seen |= kSeenOrdType;
+                    break;
+                case 111:
+                    if (!fix_detail::parse_uint(v, len, u)) return fail(FixStatus::Malformed);
+                    if (u != 0) return fail(FixStatus::Unsupported); // no icebergs
+                    out.display = Display::Hidden;
+                    break;
+                default:
+                    break; // header and body tags the engine has no use for
+            }
+            return true;
+        });
+        if (st != FixStatus::Ok) return st;
+        if (!well_formed) return FixStatus::Malformed;
+        if ((seen & (kSeenType | kSeenSeq)) != (kSeenType | kSeenSeq)) return FixStatus::MissingField;
+        constexpr std::uint32_t kOrder = kSeenId | kSeenSide | kSeenQty | kSeenPrice | kSeenOrdType;
+        std::uint32_t need = 0;
+        switch (out.msg_type) {
+            case 'D': out.kind = FixRequest::Kind::NewOrder; need = kOrder; break;
+            case 'F': out.kind = FixRequest::Kind::Cancel; need = kSeenOrig; break;
+            case 'G': out.kind = FixRequest::Kind::Replace; need = kOrder | kSeenOrig; break;
+            case '0': case '1': case '2': case '3': case '4': case '5': case 'A':
+                out.kind = FixRequest::Kind::Admin;
+                break;
+            default:
+                return FixStatus::Unsupported;
+        }
+        return (seen & need) == need ? FixStatus::Ok : FixStatus::MissingField;
+    }
+
+    int decimals_;
+};
+
+// One inbound FIX connection. Complete messages are decoded straight out of
+// the caller's bytes; only a trailing partial message is copied aside.
+class FixSession {
+public:
+    static constexpr std::size_t kBufferSize = 2 * (FixParser::kMaxBody + 64);
+
+    struct Stats {
+        std::uint64_t requests{}; // handed on
+        std::uint64_t admin{};
+        std::uint64_t rejected{}; // bad checksum, malformed, missing field, unsupported
+        std::uint64_t gaps{};     // MsgSeqNum ahead of the expected one
+        std::uint64_t dupes{};    // MsgSeqNum behind it; dropped
+        FixStatus     last_error{FixStatus::Ok};
+    };
+
+    explicit FixSession(int price_decimals = 0)
+        : parser_(price_decimals), buf_(std::make_unique<char[]>(kBufferSize)) {}
+
+    // Calls on_request(const FixRequest &) for each valid application
+    // message, in order. False once framing is lost; drop the connection.
+    template <typename F>
+    bool feed(const char *data, std::size_t n, F &&on_request) {
+        while (n > 0 && !failed_) {
+            if (len_ == 0) {
+                std::size_t used = drain(data, n, on_request);
+                data += used;
+                n -= used;
+                if (failed_) break;
+                std::memcpy(buf_.get(), data, n); // a partial message: shorter than the buffer
+                len_ = n;
+                return true;
+            }
+            std::size_t take = std::min(n, kBufferSize - len_);
+            std::memcpy(buf_.get() + len_, data, take);
+            len_ += take;
+            data += take;
+            n -= take;
+            std::size_t used = drain(buf_.get(), len_, on_request);
+            std::memmove(buf_.get(), buf_.get() + used, len_ - used);
+            len_ -= used;
+        }
+        return !failed_;
+    }
+
+    const Stats &stats() const { return stats_; }
+    std::uint64_t next_seq() const { return next_seq_; }
+    bool failed() const { return failed_; }
+
+private:
+    template <typename F>
+    std::size_t drain(const char *p, std::size_t n, F &on_request) {
+        std::size_t off = 0;
+        while (off < n) {
+            std::size_t used = 0;
+            FixStatus st = parser_.parse(p + off, n - off, req_, used);
+            if (st == FixStatus::Incomplete) break;
+            if (st == FixStatus::BadFrame) {
+                stats_.last_error = st;
+                failed_ = true;
+                break;
+            }
+            off += used;
+            if (st != FixStatus::Ok) {
+                ++stats_.rejected;
+                stats_.last_error = st;
+                continue;
+            }
+            if (req_.seq < next_seq_) {
+                ++stats_.dupes;
+                continue;
+            }
+            if (req_.seq > next_seq_) ++stats_.gaps;
+            next_seq_ = req_.seq + 1;
+            if (req_.kind == FixRequest::Kind::Admin) {
+                ++stats_.admin;
+                continue;
+            }
+            ++stats_.requests;
+            on_request(static_cast<const FixRequest &>(req_));
+        }
+        return off;
+    }
+
+    FixParser parser_;
+    std::unique_ptr<char[]> buf_;
+    std::size_t len_ = 0;
+    FixRequest req_{};
+    std::uint64_t next_seq_ = 1;
+    bool failed_ = false;
+    Stats stats_{};
+};
+
+// Hands a decoded request to the engine, with MsgSeqNum as its RequestId.
+inline void route(AsyncMatchingEngine &eng, const FixRequest &r) {
+    Order o = r.order;
+    o.ts = Clock::now();
+    switch (r.kind) {
+        case FixRequest::Kind::NewOrder: eng.submit(o, r.display, r.seq); break;
+        case FixRequest::Kind::Cancel:   eng.cancel(r.orig, r.seq); break;
+        case FixRequest::Kind::Replace:  eng.replace(r.orig, o, r.display, r.seq); break;
+        case FixRequest::Kind::Admin:    break;
+    }
+}
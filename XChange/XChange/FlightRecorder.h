@@ -0,0 +1,236 @@
+//
+//  FlightRecorder.h
+//  XChange
+//
+//  Created by Williams on 17/10/2026.
+//
+#pragma once
+#include "TscClock.h"
+
+#include <algorithm>
+#include <csignal>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <memory>
+#include <unistd.h>
+
+// --- Flight recorder: last N engine events per thread, for post-mortems ---
+//
+// Each recording thread owns a power-of-two ring of fixed 64-byte events and
+// overwrites the oldest on wrap. Recording is a TLS load, one cache-line
+// store and a release store of the head: no locks, no sharing. dump() only
+// uses open/write/close, so it is safe from a signal handler.
+//
+// Dump layout: FlightDumpHeader, then per ring a FlightRingHeader followed by
+// its `capacity` raw events. flight_decode() turns a dump into text.
+
+enum class FlightEventType : std::uint8_t {
+    NewOrder = 1, // inbound order (id, side, price, qty)
+    Cancel,       // inbound cancel (id)
+    Trade,        // id = maker, other = taker
+    BookAdd,      // residual rested (id, side, price, qty)
+    BookRemove,   // cancel hit the book (id)
+    Stamp,        // timing point; other = ingress tsc of the command
+    Execution,    // taker summary (id, qty filled, price = last level, other = levels touched)
+};
+
+struct alignas(64) FlightEvent {
+    TscTicks        tsc;
+    SeqNo           seq;
+    OrderId         id;
+    std::uint64_t   other;
+    Price           price;
+    Qty             qty;
+    FlightEventType type;
+    std::uint8_t    side;
+};
+static_assert(sizeof(FlightEvent) == 64);
+
+struct FlightDumpHeader {
+    char          magic[4]{'X', 'C', 'F', 'R'};
+    std::uint32_t version{1};
+    std::uint32_t event_size{sizeof(FlightEvent)};
+    std::uint32_t rings{};
+    double        ns_per_tick{};
+};
+
+struct FlightRingHeader {
+    std::uint32_t thread{};
+    std::uint32_t capacity{};
+    std::uint64_t head{}; // events ever written
+};
+
+class FlightRecorder {
+public:
+    static constexpr std::uint32_t kMaxThreads = 64;
+
+    // Turns recording on; threads that record afterwards get a ring of
+    // `events_per_thread` (rounded up to a power of two).
+    static void enable(std::uint32_t events_per_thread = 1u << 16) {
+        TscClock::calibrate();
+        std::uint32_t cap = 1;
+        while (cap < events_per_thread) cap <<= 1;
+        state().capacity.store(cap, std::memory_order_relaxed);
+        state().ns_per_tick = TscClock::ns_per_tick();
+        state().enabled.store(true, std::memory_order_release);
+    }
+
+    static void record(FlightEventType type, SeqNo seq, OrderId id, std::uint64_t other = 0,
+                       Price price = 0, Qty qty = 0, std::uint8_t side = 0) {
+        Ring *r = local();
+        if (!r) return;
+        std::uint64_t h = r->head.load(std::memory_order_relaxed);
+        FlightEvent &e = r->events[h & r->mask];
+        e.tsc = tsc_now();
+        e.seq = seq;
+        e.id = id;
+        e.other = other;
+        e.price = price;
+        e.qty = qty;
+        e.type = type;
+        e.side = side;
+        r->head.store(h + 1, std::memory_order_release);
+    }
+
+    // Allocates (and faults in) this thread's ring now rather than on its
+    // first record(). No-op while disabled.
+    static void prepare_thread() { (void)local(); }
+
+    // Writes every ring to `path`. Async-signal-safe; events being written
+    // concurrently may come out torn.
+    static bool dump(const char *path) {
+        int fd = ::open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0) return false;
+        State &st = state();
+        std::uint32_t n = std::min(st.registered.load(std::memory_order_acquire), kMaxThreads);
+        Ring *rings[kMaxThreads];
+        FlightDumpHeader h{};
+        for (std::uint32_t i = 0; i < n; ++i) {
+            rings[i] = st.rings[i].load(std::memory_order_acquire);
+            if (rings[i]) ++h.rings;
+        }
+        h.ns_per_tick = st.ns_per_tick;
+        bool ok = write_all(fd, &h, sizeof(h));
+        for (std::uint32_t i = 0; ok && i < n; ++i) {
+            Ring *r = rings[i];
+            if (!r) continue;
+            FlightRingHeader rh{i, r->mask + 1, r->head.load(std::memory_order_acquire)};
+            ok = write_all(fd, &rh, sizeof(rh))
+              && write_all(fd, r->events.get(), sizeof(FlightEvent) * (r->mask + 1));
+        }
+        ::close(fd);
+        return ok;
+    }
+
+    // Dumps to `path` whenever `sig` arrives (e.g. kill -USR1 <pid>).
+    static void dump_on_signal(const char *path, int sig = SIGUSR1) {
+        std::strncpy(state().signal_path, path, sizeof(state().signal_path) - 1);
+        std::signal(sig, [](int){ dump(state().signal_path); });
+    }
+
+private:
+    struct Ring {
+        std::unique_ptr<FlightEvent[]> events;
+        std::uint32_t mask{};
+        std::atomic<std::uint64_t> head{0};
+    };
+
+    struct State {
+        std::atomic<bool> enabled{false};
+        std::atomic<std::uint32_t> capacity{0};
+        std::atomic<std::uint32_t> registered{0};
+        std::atomic<Ring *> rings[kMaxThreads]{};
+        double ns_per_tick{1.0};
+        char signal_path[256]{};
+    };
+
+    static State &state() {
+        static State st;
+        return st;
+    }
+
+    // Rings live until exit so a dump after a thread ended still sees them.
+    static Ring *local() {
+        thread_local Ring *ring = nullptr;
+        thread_local bool tried = false;
+        if (ring || tried) return ring;
+        State &st = state();
+        if (!st.enabled.load(std::memory_order_acquire)) return nullptr;
+        tried = true;
+        std::uint32_t slot = st.registered.fetch_add(1, std::memory_order_acq_rel);
+        if (slot >= kMaxThreads) return nullptr;
+        auto *r = new Ring;
+        std::uint32_t cap = st.capacity.load(std::memory_order_relaxed);
+        r->events = std::make_unique<FlightEvent[]>(cap);
+        r->mask = cap - 1;
+        st.rings[slot].store(r, std::memory_order_release);
+        ring = r;
+        return ring;
+    }
+
+    static bool write_all(int fd, const void *buf, std::size_t n) {
+        auto p = static_cast<const char *>(buf);
+        while (n > 0) {
+            ssize_t w = ::write(fd, p, n);
+            if (w <= 0) return false;
+            p += w;
+            n -= static_cast<std::size_t>(w);
+        }
+        return true;
+    }
+};
+
+// --- Decoder: dump file -> one text line per event, all threads merged by time ---
+inline bool flight_decode(const std::string &path, std::ostream &os) {
+    std::FILE *f = std::fopen(path.c_str(), "rb");
+    if (!f) return false;
+    FlightDumpHeader h{};
+    if (std::fread(&h, sizeof(h), 1, f) != 1 || std::memcmp(h.magic, "XCFR", 4) != 0
+        || h.event_size != sizeof(FlightEvent)) {
+        std::fclose(f);
+        return false;
+    }
+    std::vector<std::pair<std::uint32_t, FlightEvent>> events;
+    for (std::uint32_t i = 0; i < h.rings; ++i) {
+        FlightRingHeader rh{};
+        if (std::fread(&rh, sizeof(rh), 1, f) != 1) break;
+        std::vector<FlightEvent> ring(rh.capacity);
+        if (std::fread(ring.data(), sizeof(FlightEvent), rh.capacity, f) != rh.capacity) break;
+        std::uint64_t first = rh.head > rh.capacity ? rh.head - rh.capacity : 0;
+        for (std::uint64_t k = first; k < rh.head; ++k)
+            events.emplace_back(rh.thread, ring[k & (rh.capacity - 1)]);
+    }
+    std::fclose(f);
+    std::stable_sort(events.begin(), events.end(),
+                     [](auto const &a, auto const &b){ return a.second.tsc < b.second.tsc; });
+
+    static const char *names[] = {"?", "NEW", "CANCEL", "TRADE", "BOOK_ADD", "BOOK_REMOVE", "STAMP", "EXECUTION"};
+    TscTicks t0 = events.empty() ? 0 : events.front().second.tsc;
+    for (auto const &[thread, e] : events) {
+        auto type = static_cast<std::size_t>(e.type);
+        auto ns = static_cast<std::int64_t>(static_cast<double>(e.tsc - t0) * h.ns_per_tick);
+        os << "+" << ns << "ns t" << thread << " seq=" << e.seq << " "
+           << (type < std::size(names) ? names[type] : "?");
+        switch (e.type) {
+            case FlightEventType::NewOrder:
+            case FlightEventType::BookAdd:
+                os << " id=" << e.id << (e.side == 0 ? " BUY " : " SELL ") << e.qty << "@" << e.price;
+                break;
+            case FlightEventType::Trade:
+                os << " maker=" << e.id << " taker=" << e.other << " " << e.qty << "@" << e.price;
+                break;
+            case FlightEventType::Execution:
+                os << " taker=" << e.id << " filled=" << e.qty << " last=" << e.price << " levels=" << e.other;
+                break;
+            case FlightEventType::Stamp:
+                os << " since_ingress="
+                   << static_cast<std::int64_t>(static_cast<double>(e.tsc - e.other) * h.ns_per_tick) << "ns";
+                break;
+            default:
+                os << " id=" << e.id;
+        }
+        os << "\n";
+    }
+    return true;
+}
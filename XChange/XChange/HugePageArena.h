@@ -0,0 +1,126 @@
+//
+//  HugePageArena.h
+//  XChange
+//
+//  Created by Williams on 17/10/2026.
+//
+#pragma once
+#include "Types.h"
+
+#include <memory_resource>
+#include <new>
+#include <sys/mman.h>
+
+// --- 2MB-page backed memory for books, pools and queues ---
+//
+// Large resting books scatter nodes over the heap and the random-access
+// cancel path pays a TLB miss per node. Carving them out of 2MB pages keeps
+// the working set inside a handful of TLB entries.
+//
+// Fallback order: explicit hugetlb pages (MAP_HUGETLB, needs reserved pages),
+// transparent hugepages (2MB-aligned mapping + MADV_HUGEPAGE), plain pages.
+
+inline constexpr std::size_t kHugePageSize = std::size_t{2} << 20;
+
+enum class HugePageKind : std::uint8_t { Explicit, Transparent, Regular };
+
+struct HugePageRegion {
+    void         *ptr{};
+    std::size_t   bytes{};
+    HugePageKind  kind{HugePageKind::Regular};
+};
+
+inline HugePageRegion map_huge(std::size_t bytes) {
+    bytes = (bytes + kHugePageSize - 1) & ~(kHugePageSize - 1);
+#ifdef MAP_HUGETLB
+    void *p = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if (p != MAP_FAILED) return {p, bytes, HugePageKind::Explicit};
+#endif
+    // Over-map by one page and trim so the region is 2MB aligned; THP can
+    // only back aligned 2MB extents.
+    std::size_t span = bytes + kHugePageSize;
+    void *raw = ::mmap(nullptr, span, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (raw == MAP_FAILED) throw std::bad_alloc();
+    auto lo = reinterpret_cast<std::uintptr_t>(raw);
+    auto aligned = (lo + kHugePageSize - 1) & ~(kHugePageSize - 1);
+    if (aligned > lo) ::munmap(raw, aligned - lo);
+    std::size_t tail = lo + span - (aligned + bytes);
+    if (tail > 0) ::munmap(reinterpret_cast<void *>(aligned + bytes), tail);
+
+    HugePageRegion r{reinterpret_cast<void *>(aligned), bytes, HugePageKind::Regular};
+#ifdef MADV_HUGEPAGE
+    if (::madvise(r.ptr, bytes, MADV_HUGEPAGE) == 0) r.kind = HugePageKind::Transparent;
+#endif
+    return r;
+}
+
+inline void unmap_huge(const HugePageRegion &r) { ::munmap(r.ptr, r.bytes); }
+
+// Monotonic memory_resource over hugepage chunks. Never returns memory until
+// destroyed; put a std::pmr pool resource in front of it for reuse:
+//
+//     HugePageResource huge;
+//     std::pmr::unsynchronized_pool_resource pool{&huge};
+//     OrderBook book{&pool};
+//
+// Refills are rare and take a mutex, so several pools on different threads
+// can share one upstream.
+class HugePageResource : public std::pmr::memory_resource {
+public:
+    struct Stats {
+        std::size_t bytes_mapped{};
+        std::size_t bytes_allocated{};
+        std::size_t explicit_chunks{};
+        std::size_t transparent_chunks{};
+        std::size_t regular_chunks{};
+    };
+
+    explicit HugePageResource(std::size_t chunk_bytes = 16 * kHugePageSize)
+        : chunk_bytes_(chunk_bytes) {}
+
+    ~HugePageResource() override {
+        for (auto const &r : chunks_) unmap_huge(r);
+    }
+    HugePageResource(const HugePageResource &) = delete;
+    HugePageResource &operator=(const HugePageResource &) = delete;
+
+    Stats stats() const {
+        std::lock_guard<std::mutex> lk(m_);
+        return stats_;
+    }
+
+private:
+    void *do_allocate(std::size_t bytes, std::size_t align) override {
+        std::lock_guard<std::mutex> lk(m_);
+        auto p = (cur_ + align - 1) & ~(align - 1);
+        if (cur_ == 0 || p + bytes > end_) {
+            HugePageRegion r = map_huge(std::max(chunk_bytes_, bytes + align));
+            chunks_.push_back(r);
+            stats_.bytes_mapped += r.bytes;
+            switch (r.kind) {
+                case HugePageKind::Explicit:    ++stats_.explicit_chunks; break;
+                case HugePageKind::Transparent: ++stats_.transparent_chunks; break;
+                case HugePageKind::Regular:     ++stats_.regular_chunks; break;
+            }
+            cur_ = reinterpret_cast<std::uintptr_t>(r.ptr);
+            end_ = cur_ + r.bytes;
+            p = (cur_ + align - 1) & ~(align - 1);
+        }
+        cur_ = p + bytes;
+        stats_.bytes_allocated += bytes;
+        return reinterpret_cast<void *>(p);
+    }
+
+    void do_deallocate(void *, std::size_t, std::size_t) override {}
+
+    bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override {
+        return this == &other;
+    }
+
+    std::size_t chunk_bytes_;
+    mutable std::mutex m_;
+    std::vector<HugePageRegion> chunks_;
+    std::uintptr_t cur_ = 0, end_ = 0;
+    Stats stats_{};
+};
@@ -0,0 +1,292 @@
+//
+//  Instruments.h
+//  XChange
+//
+//  Created by Williams on 17/10/2026.
+//
+#pragma once
+#include "Types.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <type_traits>
+#include <unistd.h>
+
+// --- Instrument reference data: tick/lot sizes, price controls, policy ---
+//
+// Loaded once at startup. Each spec is compiled into InstrumentRules: tick
+// and lot become Divisors (no check for 1, a mask for powers of two, a
+// multiply by the modular inverse otherwise), and the order check is a
+// function pointer to the template instance for that pair of kinds, picked
+// at load time. Validation never divides.
+//
+// File format, one instrument per line ('#' starts a comment):
+//   id symbol tick lot reference band_bps halt_bps halt_window_ms policy
+// where policy is "continuous" or "auction" (start halted, rest until resume).
+// Ids index a dense array and may not exceed InstrumentTable::kMaxId.
+//
+// For fast startup the same table can be saved as a binary file: an
+// InstrumentFileHeader followed by raw InstrumentSpec records, mapped and
+// compiled in place instead of parsed.
+
+enum class MatchingPolicy : std::uint8_t { Continuous, Auction };
+
+enum class RejectReason : std::uint8_t {
+    None,
+    UnknownInstrument,
+    Tick,
+    Lot,          // not a positive multiple of the lot
+    PriceBand,    // outside the book's price band
+    UnknownOrder, // cancel of an order that is not resting
+};
+
+struct InstrumentSpec {
+    InstrumentId   id{};
+    char           symbol[16]{};
+    Price          tick{1};
+    Qty            lot{1};
+    PriceControls  controls{};
+    MatchingPolicy policy{MatchingPolicy::Continuous};
+};
+
+static_assert(std::is_trivially_copyable_v<InstrumentSpec>);
+
+struct InstrumentFileHeader {
+    char          magic[4]{'X', 'C', 'I', 'N'};
+    std::uint32_t version{1};
+    std::uint32_t record_size{sizeof(InstrumentSpec)};
+    std::uint32_t count{};
+};
+
+// Exact divisibility by a fixed d > 0. For d = odd << k, x is a multiple of
+// d iff rotr(x * odd^-1 mod 2^64, k) <= (2^64 - 1) / d (Hacker's Delight 10-17).
+class Divisor {
+public:
+    enum class Kind : std::uint8_t { One, Pow2, General };
+
+    explicit Divisor(std::uint64_t d = 1) : d_(d) {
+        if (d == 0) throw std::invalid_argument("divisor: zero");
+        if (d == 1) {
+            kind_ = Kind::One;
+        } else if ((d & (d - 1)) == 0) {
+            kind_ = Kind::Pow2;
+            mask_ = d - 1;
+        } else {
+            kind_ = Kind::General;
+            shift_ = static_cast<unsigned>(__builtin_ctzll(d));
+            std::uint64_t odd = d >> shift_;
+            std::uint64_t inv = odd; // Newton: each step doubles the correct low bits
+            for (int i = 0; i < 5; ++i) inv *= 2 - odd * inv;
+            inv_ = inv;
+            limit_ = ~std::uint64_t{0} / d; // once, at load
+        }
+    }
+
+    template <Kind K>
+    bool divides(std::uint64_t x) const {
+        if constexpr (K == Kind::One) {
+            return true;
+        } else if constexpr (K == Kind::Pow2) {
+            return (x & mask_) == 0;
+        } else {
+            std::uint64_t q = x * inv_;
+            if (shift_) q = (q >> shift_) | (q << (64 - shift_));
+            return q <= limit_;
+        }
+    }
+
+    bool divides(std::uint64_t x) const {
+        switch (kind_) {
+            case Kind::One:  return divides<Kind::One>(x);
+            case Kind::Pow2: return divides<Kind::Pow2>(x);
+            default:         return divides<Kind::General>(x);
+        }
+    }
+
+    Kind kind() const { return kind_; }
+    std::uint64_t value() const { return d_; }
+
+private:
+    std::uint64_t d_;
+    Kind          kind_{Kind::One};
+    unsigned      shift_ = 0;
+    std::uint64_t mask_ = 0, inv_ = 0, limit_ = 0;
+};
+
+// Hot-path form of an InstrumentSpec.
+struct InstrumentRules {
+    using Check = RejectReason (*)(const InstrumentRules &, Price, Qty);
+
+    Divisor tick, lot;
+    Check   check = &check_impl<Divisor::Kind::One, Divisor::Kind::One>;
+
+    InstrumentRules() = default;
+    explicit InstrumentRules(const InstrumentSpec &spec)
+        : tick(static_cast<std::uint64_t>(spec.tick)), lot(static_cast<std::uint64_t>(spec.lot)) {
+        static constexpr Check kChecks[3][3] = {
+            {check_impl<Divisor::Kind::One, Divisor::Kind::One>, check_impl<Divisor::Kind::One, Divisor::Kind::Pow2>,
+             check_impl<Divisor::Kind::One, Divisor::Kind::General>},
+            {check_impl<Divisor::Kind::Pow2, Divisor::Kind::One>, check_impl<Divisor::Kind::Pow2, Divisor::Kind::Pow2>,
+             check_impl<Divisor::Kind::Pow2, Divisor::Kind::General>},
+            {check_impl<Divisor::Kind::General, Divisor::Kind::One>, check_impl<Divisor::Kind::General, Divisor::Kind::Pow2>,
+             check_impl<Divisor::Kind::General, Divisor::Kind::General>},
+        };
+        check = kChecks[static_cast<int>(tick.kind())][static_cast<int>(lot.kind())];
+    }
+
+    RejectReason validate(Price price, Qty qty) const { return check(*this, price, qty); }
+
+    template <Divisor::Kind T, Divisor::Kind L>
+    static RejectReason check_impl(const InstrumentRules &r, Price price, Qty qty) {
+        auto mag = [](std::int64_t v) { return v < 0 ? 0 - static_cast<std::uint64_t>(v) : static_cast<std::uint64_t>(v); };
+        if (!r.tick.divides<T>(mag(price))) return RejectReason::Tick;
+        if (qty <= 0 || !r.lot.divides<L>(static_cast<std::uint64_t>(qty))) return RejectReason::Lot;
+        return RejectReason::None;
+    }
+};
+
+class InstrumentTable {
+public:
+    // Ids index a dense array, so they are capped.
+    static constexpr InstrumentId kMaxId = (InstrumentId{1} << 20) - 1;
+
+    void add(const InstrumentSpec &spec) {
+        if (spec.id > kMaxId)
+            throw std::invalid_argument("instruments: id " + std::to_string(spec.id) + " is over "
+                                        + std::to_string(kMaxId));
+        if (spec.tick <= 0 || spec.lot <= 0)
+            throw std::invalid_argument("instruments: tick and lot must be positive for " + std::to_string(spec.id));
+        if (spec.id >= slots_.size()) slots_.resize(spec.id + 1);
+        Slot &s = slots_[spec.id];
+        if (!s.present) ++count_;
+        s = Slot{true, spec, InstrumentRules(spec)};
+    }
+
+    const InstrumentSpec *find(InstrumentId id) const {
+        return id < slots_.size() && slots_[id].present ? &slots_[id].spec : nullptr;
+    }
+
+    const InstrumentRules *rules(InstrumentId id) const {
+        return id < slots_.size() && slots_[id].present ? &slots_[id].rules : nullptr;
+    }
+
+    RejectReason validate(InstrumentId id, Price price, Qty qty) const {
+        const InstrumentRules *r = rules(id);
+        return r ? r->validate(price, qty) : RejectReason::UnknownInstrument;
+    }
+
+    std::size_t size() const { return count_; }
+
+    template <typename F>
+    void for_each(F &&f) const {
+        for (auto const &s : slots_)
+            if (s.present) f(s.spec);
+    }
+
+    static InstrumentTable parse(std::istream &in) {
+        InstrumentTable t;
+        std::string line;
+        for (std::size_t n = 1; std::getline(in, line); ++n) {
+            if (auto hash = line.find('#'); hash != std::string::npos) line.resize(hash);
+            std::istringstream ls(line);
+            InstrumentSpec s;
+            std::string symbol, policy;
+            std::int64_t window_ms = 0;
+            if (!(ls >> s.id)) continue; // blank or comment-only
+            if (!(ls >> symbol >> s.tick >> s.lot >> s.controls.reference >> s.controls.band_bps
+                     >> s.controls.halt_move_bps >> window_ms >> policy))
+                throw std::runtime_error("instruments: line " + std::to_string(n) + ": expected 9 fields");
+            if (symbol.size() >= sizeof(s.symbol))
+                throw std::runtime_error("instruments: line " + std::to_string(n) + ": symbol too long");
+            std::memcpy(s.symbol, symbol.data(), symbol.size());
+            s.controls.halt_window = std::chrono::milliseconds(window_ms);
+            if (policy == "continuous") s.policy = MatchingPolicy::Continuous;
+            else if (policy == "auction") s.policy = MatchingPolicy::Auction;
+            else throw std::runtime_error("instruments: line " + std::to_string(n) + ": unknown policy " + policy);
+            try {
+                t.add(s);
+            } catch (const std::invalid_argument &e) {
+                throw std::runtime_error("instruments: line " + std::to_string(n) + ": " + e.what());
+            }
+        }
+        return t;
+    }
+
+    void save_binary(const std::string &path) const {
+        std::vector<InstrumentSpec> specs;
+        specs.reserve(count_);
+        for_each([&](const InstrumentSpec &s) { specs.push_back(s); });
+        InstrumentFileHeader h{};
+        h.count = static_cast<std::uint32_t>(specs.size());
+        std::FILE *f = std::fopen(path.c_str(), "wb");
+        if (!f) throw std::runtime_error("instruments: cannot create " + path);
+        bool ok = std::fwrite(&h, sizeof(h), 1, f) == 1
+               && std::fwrite(specs.data(), sizeof(InstrumentSpec), specs.size(), f) == specs.size();
+        ok = std::fclose(f) == 0 && ok;
+        if (!ok) throw std::runtime_error("instruments: write failed for " + path);
+    }
+
+    // Maps the file and compiles the specs straight out of the mapping.
+    static InstrumentTable load_binary(const std::string &path) {
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) throw std::runtime_error("instruments: cannot open " + path);
+        struct stat st{};
+        if (::fstat(fd, &st) != 0) {
+            ::close(fd);
+            throw std::runtime_error("instruments: cannot stat " + path);
+        }
+        auto size = static_cast<std::size_t>(st.st_size);
+        void *p = size >= sizeof(InstrumentFileHeader) ? ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0) : MAP_FAILED;
+        ::close(fd);
+        if (p == MAP_FAILED) throw std::runtime_error("instruments: cannot map " + path);
+        auto base = static_cast<const char *>(p);
+        InstrumentFileHeader h;
+        std::memcpy(&h, base, sizeof(h));
+        bool ok = std::memcmp(h.magic, InstrumentFileHeader{}.magic, 4) == 0 && h.version == InstrumentFileHeader{}.version
+               && h.record_size == sizeof(InstrumentSpec)
+               && size >= sizeof(h) + std::size_t{h.count} * sizeof(InstrumentSpec);
+        InstrumentTable t;
+        std::string err = "instruments: bad or truncated " + path;
+        if (ok) {
+            auto specs = reinterpret_cast<const InstrumentSpec *>(base + sizeof(h));
+            InstrumentId max_id = 0;
+            for (std::uint32_t i = 0; i < h.count; ++i) max_id = std::max(max_id, specs[i].id);
+            if (max_id > kMaxId) { // checked before sizing the array from it
+                ok = false;
+                err = "instruments: id " + std::to_string(max_id) + " is over " + std::to_string(kMaxId) + " in " + path;
+            } else {
+                if (h.count) t.slots_.resize(std::size_t{max_id} + 1);
+                try {
+                    for (std::uint32_t i = 0; i < h.count; ++i) t.add(specs[i]);
+                } catch (const std::invalid_argument &e) {
+                    ok = false;
+                    err = std::string(e.what()) + " in " + path;
+                }
+            }
+        }
+        ::munmap(p, size);
+        if (!ok) throw std::runtime_error(err);
+        return t;
+    }
+
+    static InstrumentTable load(const std::string &path) {
+        std::ifstream in(path);
+        if (!in) throw std::runtime_error("instruments: cannot open " + path);
+        return parse(in);
+    }
+
+private:
+    struct Slot {
+        bool            present = false;
+        InstrumentSpec  spec{};
+        InstrumentRules rules{};
+    };
+    std::vector<Slot> slots_;
+    std::size_t count_ = 0;
+};
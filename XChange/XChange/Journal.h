@@ -0,0 +1,408 @@
+//
+//  Journal.h
+//  XChange
+//
+//  Created by Williams on 17/10/2026.
+//
+#pragma once
+#include "Crc32c.h"
+#include "Types.h"
+
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+// --- Journal: append-only file of sequenced Commands ---
+// Layout: JournalFileHeader followed by raw Command records. Written ahead of
+// the book (write-ahead log) so any state can be rebuilt or rolled forward.
+
+struct JournalFileHeader {
+    char          magic[4]{'X', 'C', 'J', 'L'};
+    std::uint32_t version{11}; // 2: Command carries an instrument id; 3: a Display; 4: a RequestId; 5: Replace; 6: crc;
+                              // 7: no padding (64-bit Side, reserved fields); 8: Controls, no rejects; 9: Resume;
+                              // 10: clock_ns; 11: ControlsFields
+    std::uint32_t record_size{sizeof(Command)};
+    std::uint32_t reserved{0};
+};
+
+// Records are raw Commands whose `crc` covers the bytes before it, so a
+// reader (or a mapped scan) can check each record on its own.
+inline std::uint32_t journal_record_crc(const Command &c) { return crc32c(&c, offsetof(Command, crc)); }
+
+inline bool journal_record_ok(const Command &c) { return c.crc == journal_record_crc(c); }
+
+class JournalWriter {
+public:
+    explicit JournalWriter(const std::string &path) {
+        f_ = std::fopen(path.c_str(), "ab");
+        if (!f_) throw std::runtime_error("journal: cannot open " + path);
+        std::fseek(f_, 0, SEEK_END);
+        if (std::ftell(f_) == 0) {
+            JournalFileHeader h{};
+            std::fwrite(&h, sizeof(h), 1, f_);
+        }
+    }
+    ~JournalWriter() { if (f_) std::fclose(f_); }
+    JournalWriter(const JournalWriter &) = delete;
+    JournalWriter &operator=(const JournalWriter &) = delete;
+
+    void append(Command c) {
+        c.crc = journal_record_crc(c);
+        std::fwrite(&c, sizeof(c), 1, f_);
+    }
+
+    // Hands buffered records to the OS; enough to survive a process crash.
+    void flush() { std::fflush(f_); }
+
+private:
+    std::FILE *f_ = nullptr;
+};
+
+class JournalReader {
+public:
+    explicit JournalReader(const std::string &path) {
+        f_ = std::fopen(path.c_str(), "rb");
+        if (!f_) throw std::runtime_error("journal: cannot open " + path);
+        JournalFileHeader h{};
+        if (std::fread(&h, sizeof(h), 1, f_) != 1
+            || std::memcmp(h.magic, JournalFileHeader{}.magic, 4) != 0
+            || h.version != JournalFileHeader{}.version
+            || h.record_size != sizeof(Command)) {
+            std::fclose(f_);
+            throw std::runtime_error("journal: bad header in " + path);
+        }
+    }
+    ~JournalReader() { if (f_) std::fclose(f_); }
+    JournalReader(const JournalReader &) = delete;
+    JournalReader &operator=(const JournalReader &) = delete;
+
+    // False at end of file; a torn trailing record is ignored, as is the
+    // zero padding an AsyncJournalWriter can leave behind a crash (seq 0).
+    // A record failing its checksum ends the stream with corrupt().
+    bool next(Command &c) {
+        if (corrupt_ || std::fread(&c, sizeof(c), 1, f_) != 1 || c.seq == 0) return false;
+        corrupt_ = !journal_record_ok(c);
+        return !corrupt_;
+    }
+
+    bool corrupt() const { return corrupt_; }
+
+private:
+    std::FILE *f_ = nullptr;
+    bool corrupt_ = false;
+};
+
+// --- Compressed journal: delta + varint records in checksummed blocks ---
+// Layout: JournalFileHeader (magic XCJZ) followed by blocks, each a
+// JournalBlockHeader and `bytes` of records. A record is a flag byte and
+// varints: seq, order id, price, timestamps and request id as zigzag deltas
+// against the previous record of the block, so the common case (next seq,
+// nearby id and price, a few microseconds later) takes a byte or two per
+// field. Delta state restarts at every block, so a block decodes on its own
+// and a torn or corrupt block costs only itself.
+
+struct JournalBlockHeader {
+    std::uint32_t bytes{};    // record bytes that follow
+    std::uint32_t records{};
+    std::uint32_t checksum{}; // CRC32C of the records
+    std::uint32_t reserved{};
+};
+
+namespace journal_detail {
+
+// 2: CRC32C blocks; 3: Controls; 4: Resume; 5: clock_ns; 6: Controls fields
+inline constexpr JournalFileHeader kCompressedHeader{{'X', 'C', 'J', 'Z'}, 6, 0, 0};
+inline constexpr std::size_t kBlockBytes = 64 * 1024; // sealed once a block reaches this
+inline constexpr std::size_t kMaxRecord = 2 + 11 * 10; // flags, extras, up to eleven varints (a Controls)
+
+// Record flags.
+inline constexpr std::uint8_t kTypeMask   = 0x03;
+inline constexpr std::uint8_t kHidden     = 0x04;
+inline constexpr std::uint8_t kSell       = 0x08;
+inline constexpr std::uint8_t kSeqJump    = 0x10; // seq is not previous + 1
+inline constexpr std::uint8_t kNewInst    = 0x20; // instrument differs from previous
+inline constexpr std::uint8_t kExtras     = 0x40; // an extras byte follows
+inline constexpr std::uint8_t kBody       = 0x80; // side, price and qty present
+// Extras byte.
+inline constexpr std::uint8_t kRequest    = 0x01;
+inline constexpr std::uint8_t kReplaces   = 0x02;
+inline constexpr std::uint8_t kIngressTsc = 0x04;
+inline constexpr std::uint8_t kTypeHigh   = 0x08; // add 4 to the type in flags
+inline constexpr std::uint8_t kClock      = 0x10; // clock_ns differs from previous
+
+inline std::uint64_t zigzag(std::int64_t v) {
+    return (static_cast<std::uint64_t>(v) << 1) ^ static_cast<std::uint64_t>(v >> 63);
+}
+inline std::int64_t unzigzag(std::uint64_t v) {
+    return static_cast<std::int64_t>(v >> 1) ^ -static_cast<std::int64_t>(v & 1);
+}
+
+// Caller guarantees 10 bytes of room.
+inline char *put_varint(char *p, std::uint64_t v) {
+    while (v >= 0x80) {
+        *p++ = static_cast<char>(v | 0x80);
+        v >>= 7;
+    }
+    *p++ = static_cast<char>(v);
+    return p;
+}
+
+// nullptr if the varint runs past `end` or over 10 bytes.
+inline const char *get_varint(const char *p, const char *end, std::uint64_t &v) {
+    v = 0;
+    for (unsigned shift = 0; p < end && shift < 70; shift += 7) {
+        auto b = static_cast<std::uint8_t>(*p++);
+        v |= static_cast<std::uint64_t>(b & 0x7f) << shift;
+        if (b < 0x80) return p;
+    }
+    return nullptr;
+}
+
+// Previous record's fields, as seen by the encoder and the decoder.
+struct DeltaState {
+    SeqNo         seq{};
+    OrderId       id{};
+    Price         price{};
+    std::int64_t  ts{};
+    std::uint64_t tsc{};
+    std::int64_t  clock{};
+    InstrumentId  instrument{};
+    RequestId     request{};
+};
+
+inline std::int64_t ticks(TimePoint t) { return t.time_since_epoch().count(); }
+
+inline char *encode(char *p, const Command &c, DeltaState &s) {
+    auto type = static_cast<std::uint8_t>(c.type);
+    std::uint8_t flags = type & kTypeMask;
+    std::uint8_t extras = type > kTypeMask ? kTypeHigh : 0;
+    if (c.display == Display::Hidden) flags |= kHidden;
+    if (c.seq != s.seq + 1) flags |= kSeqJump;
+    if (c.instrument != s.instrument) flags |= kNewInst;
+    bool controls = c.type == Command::Type::Controls;
+    if (!controls && c.order.side == Side::Sell) flags |= kSell;
+    if (!controls
+        && (c.type != Command::Type::Cancel || c.order.price != 0 || c.order.qty != 0 || c.order.side != Side::Buy))
+        flags |= kBody;
+    if (c.request != 0) extras |= kRequest;
+    if (c.replaces != 0) extras |= kReplaces;
+    if (c.ingress_tsc != 0) extras |= kIngressTsc;
+    if (c.clock_ns != s.clock) extras |= kClock;
+    if (extras) flags |= kExtras;
+
+    *p++ = static_cast<char>(flags);
+    if (extras) *p++ = static_cast<char>(extras);
+    if (flags & kSeqJump) p = put_varint(p, zigzag(static_cast<std::int64_t>(c.seq - s.seq)));
+    if (flags & kNewInst) p = put_varint(p, c.instrument);
+    std::int64_t ts = s.ts;
+    if (controls) {
+        // Rare; written as they are, leaving the order deltas alone.
+        p = put_varint(p, zigzag(c.controls.reference));
+        p = put_varint(p, zigzag(c.controls.band_bps));
+        p = put_varint(p, zigzag(c.controls.halt_move_bps));
+        p = put_varint(p, zigzag(c.controls.halt_window_ns));
+        p = put_varint(p, c.controls.halt);
+    } else {
+        p = put_varint(p, zigzag(static_cast<std::int64_t>(c.order.id - s.id)));
+        if (flags & kBody) {
+            p = put_varint(p, zigzag(c.order.price - s.price));
+            p = put_varint(p, static_cast<std::uint64_t>(c.order.qty));
+            s.price = c.order.price;
+        }
+        ts = ticks(c.order.ts);
+        p = put_varint(p, zigzag(ts - s.ts));
+        s.id = c.order.id;
+    }
+    if (extras & kRequest) p = put_varint(p, zigzag(static_cast<std::int64_t>(c.request - s.request)));
+    if (extras & kReplaces) p = put_varint(p, zigzag(static_cast<std::int64_t>(c.replaces - s.id)));
+    if (extras & kIngressTsc) p = put_varint(p, zigzag(static_cast<std::int64_t>(c.ingress_tsc - s.tsc)));
+    if (extras & kClock) p = put_varint(p, zigzag(c.clock_ns - s.clock));
+
+    s.seq = c.seq;
+    s.instrument = c.instrument;
+    s.ts = ts;
+    if (extras & kRequest) s.request = c.request;
+    if (extras & kIngressTsc) s.tsc = c.ingress_tsc;
+    s.clock = c.clock_ns;
+    return p;
+}
+
+// nullptr if the record is malformed or runs past `end`.
+inline const char *decode(const char *p, const char *end, Command &c, DeltaState &s) {
+    if (p >= end) return nullptr;
+    auto flags = static_cast<std::uint8_t>(*p++);
+    std::uint8_t extras = 0;
+    if (flags & kExtras) {
+        if (p >= end) return nullptr;
+        extras = static_cast<std::uint8_t>(*p++);
+    }
+    auto type = static_cast<std::uint8_t>((flags & kTypeMask) + (extras & kTypeHigh ? 4 : 0));
+    if (type > static_cast<std::uint8_t>(Command::Type::Resume)) return nullptr;
+    std::uint64_t v = 0;
+    auto next = [&]() { return p && (p = get_varint(p, end, v)) != nullptr; };
+
+    c = Command{};
+    c.type = static_cast<Command::Type>(type);
+    c.display = flags & kHidden ? Display::Hidden : Display::Lit;
+    c.seq = s.seq + 1;
+    if ((flags & kSeqJump) && next()) c.seq = s.seq + static_cast<SeqNo>(unzigzag(v));
+    c.instrument = s.instrument;
+    if ((flags & kNewInst) && next()) c.instrument = static_cast<InstrumentId>(v);
+    std::int64_t ts = s.ts;
+    OrderId id = s.id;
+    if (c.type == Command::Type::Controls) {
+        c.controls = ControlsFields{};
+        if (next()) c.controls.reference = unzigzag(v);
+        if (next()) c.controls.band_bps = unzigzag(v);
+        if (next()) c.controls.halt_move_bps = unzigzag(v);
+        if (next()) c.controls.halt_window_ns = unzigzag(v);
+        if (next()) c.controls.halt = v;
+    } else {
+        c.order.side = flags & kSell ? Side::Sell : Side::Buy;
+        if (next()) c.order.id = id = s.id + static_cast<OrderId>(unzigzag(v));
+        if (flags & kBody) {
+            if (next()) c.order.price = s.price + unzigzag(v);
+            if (next()) c.order.qty = static_cast<Qty>(v);
+        }
+        if (next()) ts += unzigzag(v);
+        c.order.ts = TimePoint(Clock::duration(ts));
+    }
+    if ((extras & kRequest) && next()) c.request = s.request + static_cast<RequestId>(unzigzag(v));
+    if ((extras & kReplaces) && next()) c.replaces = id + static_cast<OrderId>(unzigzag(v));
+    if ((extras & kIngressTsc) && next()) c.ingress_tsc = s.tsc + static_cast<std::uint64_t>(unzigzag(v));
+    c.clock_ns = s.clock;
+    if ((extras & kClock) && next()) c.clock_ns += unzigzag(v);
+    if (!p) return nullptr;
+
+    s.seq = c.seq;
+    s.instrument = c.instrument;
+    s.id = id;
+    if (flags & kBody) s.price = c.order.price;
+    s.ts = ts;
+    if (extras & kRequest) s.request = c.request;
+    if (extras & kIngressTsc) s.tsc = c.ingress_tsc;
+    s.clock = c.clock_ns;
+    return p;
+}
+
+} // namespace journal_detail
+
+class CompressedJournalWriter {
+public:
+    explicit CompressedJournalWriter(const std::string &path) : buf_(journal_detail::kBlockBytes + journal_detail::kMaxRecord) {
+        f_ = std::fopen(path.c_str(), "ab");
+        if (!f_) throw std::runtime_error("journal: cannot open " + path);
+        std::fseek(f_, 0, SEEK_END);
+        if (std::ftell(f_) == 0) std::fwrite(&journal_detail::kCompressedHeader, sizeof(JournalFileHeader), 1, f_);
+    }
+    ~CompressedJournalWriter() {
+        if (!f_) return;
+        seal();
+        std::fclose(f_);
+    }
+    CompressedJournalWriter(const CompressedJournalWriter &) = delete;
+    CompressedJournalWriter &operator=(const CompressedJournalWriter &) = delete;
+
+    void append(const Command &c) {
+        end_ = journal_detail::encode(end_, c, state_);
+        ++records_;
+        if (static_cast<std::size_t>(end_ - buf_.data()) >= journal_detail::kBlockBytes) seal();
+    }
+
+    // Seals the open block and hands it to the OS. Blocks sealed early are
+    // smaller and compress a little worse; flush per batch, not per record.
+    void flush() {
+        seal();
+        std::fflush(f_);
+    }
+
+    std::uint64_t bytes_written() const { return written_; }
+
+private:
+    void seal() {
+        if (records_ == 0) return;
+        JournalBlockHeader h{};
+        h.bytes = static_cast<std::uint32_t>(end_ - buf_.data());
+        h.records = records_;
+        h.checksum = crc32c(buf_.data(), h.bytes);
+        std::fwrite(&h, sizeof(h), 1, f_);
+        std::fwrite(buf_.data(), 1, h.bytes, f_);
+        written_ += sizeof(h) + h.bytes;
+        end_ = buf_.data();
+        records_ = 0;
+        state_ = {};
+    }
+
+    std::FILE *f_ = nullptr;
+    std::vector<char> buf_;
+    char *end_ = buf_.data();
+    std::uint32_t records_ = 0;
+    journal_detail::DeltaState state_{};
+    std::uint64_t written_ = sizeof(JournalFileHeader);
+};
+
+class CompressedJournalReader {
+public:
+    explicit CompressedJournalReader(const std::string &path) {
+        f_ = std::fopen(path.c_str(), "rb");
+        if (!f_) throw std::runtime_error("journal: cannot open " + path);
+        JournalFileHeader h{};
+        auto const &want = journal_detail::kCompressedHeader;
+        if (std::fread(&h, sizeof(h), 1, f_) != 1 || std::memcmp(h.magic, want.magic, 4) != 0
+            || h.version != want.version) {
+            std::fclose(f_);
+            throw std::runtime_error("journal: bad header in " + path);
+        }
+    }
+    ~CompressedJournalReader() { if (f_) std::fclose(f_); }
+    CompressedJournalReader(const CompressedJournalReader &) = delete;
+    CompressedJournalReader &operator=(const CompressedJournalReader &) = delete;
+
+    // False at end of file. A torn trailing block is ignored; a block that
+    // fails its checksum or does not decode ends the stream with corrupt().
+    bool next(Command &c) {
+        while (left_ == 0)
+            if (!load()) return false;
+        const char *p = journal_detail::decode(pos_, block_.data() + block_.size(), c, state_);
+        if (!p) {
+            corrupt_ = true;
+            left_ = 0;
+            return false;
+        }
+        pos_ = p;
+        --left_;
+        return true;
+    }
+
+    bool corrupt() const { return corrupt_; }
+
+private:
+    bool load() {
+        if (corrupt_) return false;
+        JournalBlockHeader h{};
+        if (std::fread(&h, sizeof(h), 1, f_) != 1) return false;
+        if (h.bytes > journal_detail::kBlockBytes + journal_detail::kMaxRecord) { // no writer makes these
+            corrupt_ = true;
+            return false;
+        }
+        block_.resize(h.bytes);
+        if (std::fread(block_.data(), 1, h.bytes, f_) != h.bytes) return false; // torn tail
+        if (crc32c(block_.data(), h.bytes) != h.checksum) {
+            corrupt_ = true;
+            return false;
+        }
+        pos_ = block_.data();
+        left_ = h.records;
+        state_ = {};
+        return true;
+    }
+
+    std::FILE *f_ = nullptr;
+    std::vector<char> block_;
+    const char *pos_ = nullptr;
+    std::uint32_t left_ = 0;
+    journal_detail::DeltaState state_{};
+    bool corrupt_ = false;
+};
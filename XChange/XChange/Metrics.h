@@ -0,0 +1,275 @@
+//
+//  Metrics.h
+//  XChange
+//
+//  Created by Williams on 17/10/2026.
+//
+#pragma once
+#include "TscClock.h"
+
+#include <arpa/inet.h>
+#include <memory>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sstream>
+#include <sys/socket.h>
+#include <unistd.h>
+
+// --- Engine metrics, Prometheus text format over local HTTP ---
+//
+// Every thread that records gets its own cache-line aligned shard and only
+// ever writes to it (relaxed load + store, no RMW, no sharing). The scrape
+// thread sums shards when a request comes in, so the matching thread never
+// takes a lock or waits for a reader. Values that live outside the matcher
+// (queue depths, allocator stats) are sampled by the scrape thread through
+// MetricsServer::add_gauge().
+//
+// Counters and histograms are totals and sum across shards, including those
+// of threads that have exited. Gauges describe one book, so each shard's are
+// exported as their own series (shard="N"; a matcher's worker is one shard)
+// and are dropped when the thread that set them exits.
+
+enum class Counter : std::uint8_t {
+    Orders, Cancels, CancelMisses, Trades, TradedQty, Rejects, Halts,
+    Count_
+};
+
+enum class Gauge : std::uint8_t {
+    BidLevels, AskLevels, RestingOrders,
+    Count_
+};
+
+enum class Histogram : std::uint8_t {
+    QueueTicks, // ingress -> match start
+    MatchTicks, // match start -> match end
+    Count_
+};
+
+class EngineMetrics {
+public:
+    static constexpr std::size_t kCounters = static_cast<std::size_t>(Counter::Count_);
+    static constexpr std::size_t kGauges = static_cast<std::size_t>(Gauge::Count_);
+    static constexpr std::size_t kHistograms = static_cast<std::size_t>(Histogram::Count_);
+    static constexpr std::size_t kBuckets = 64; // bucket b holds values < 2^b ticks
+
+    static void inc(Counter c, std::uint64_t n = 1) {
+        auto &v = shard().counters[static_cast<std::size_t>(c)];
+        v.store(v.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+    }
+
+    static void set(Gauge g, std::int64_t value) {
+        Shard &s = shard();
+        s.gauges[static_cast<std::size_t>(g)].store(value, std::memory_order_relaxed);
+        if (!s.gauges_live.load(std::memory_order_relaxed)) s.gauges_live.store(true, std::memory_order_release);
+    }
+
+    static void observe(Histogram h, TscTicks ticks) {
+        std::size_t b = ticks == 0 ? 0 : 64 - static_cast<std::size_t>(__builtin_clzll(ticks));
+        Shard &s = shard();
+        auto &v = s.hist[static_cast<std::size_t>(h)][b < kBuckets ? b : kBuckets - 1];
+        v.store(v.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        auto &sum = s.hist_sum[static_cast<std::size_t>(h)];
+        sum.store(sum.load(std::memory_order_relaxed) + ticks, std::memory_order_relaxed);
+    }
+
+    // Registers this thread's shard now rather than on its first update.
+    static void prepare_thread() { (void)shard(); }
+
+    struct ShardGauges {
+        std::uint32_t shard{};
+        std::int64_t  values[kGauges]{};
+    };
+
+    struct Totals {
+        std::uint64_t counters[kCounters]{};
+        std::uint64_t hist[kHistograms][kBuckets]{};
+        std::uint64_t hist_sum[kHistograms]{}; // ticks
+        std::vector<ShardGauges> gauges;      // live threads that set any, by shard
+    };
+
+    // Sums all shards; called from the scrape thread.
+    static Totals collect() {
+        Totals t;
+        Registry &reg = registry();
+        std::lock_guard<std::mutex> lk(reg.m);
+        for (auto const &s : reg.shards) {
+            for (std::size_t i = 0; i < kCounters; ++i) t.counters[i] += s->counters[i].load(std::memory_order_relaxed);
+            if (s->gauges_live.load(std::memory_order_acquire)) {
+                ShardGauges &g = t.gauges.emplace_back();
+                g.shard = s->id;
+                for (std::size_t i = 0; i < kGauges; ++i) g.values[i] = s->gauges[i].load(std::memory_order_relaxed);
+            }
+            for (std::size_t h = 0; h < kHistograms; ++h) {
+                for (std::size_t b = 0; b < kBuckets; ++b) t.hist[h][b] += s->hist[h][b].load(std::memory_order_relaxed);
+                t.hist_sum[h] += s->hist_sum[h].load(std::memory_order_relaxed);
+            }
+        }
+        return t;
+    }
+
+private:
+    struct alignas(64) Shard {
+        std::atomic<std::uint64_t> counters[kCounters]{};
+        std::atomic<std::int64_t>  gauges[kGauges]{};
+        std::atomic<std::uint64_t> hist[kHistograms][kBuckets]{};
+        std::atomic<std::uint64_t> hist_sum[kHistograms]{};
+        std::atomic<bool>          gauges_live{false}; // set() called and the thread still running
+        std::uint32_t              id{};
+    };
+
+    struct Registry {
+        std::mutex m;
+        std::vector<std::unique_ptr<Shard>> shards; // kept after thread exit, for the totals
+    };
+
+    // Owned by the thread; retires its gauges when the thread exits.
+    struct Retire {
+        Shard *s = nullptr;
+        ~Retire() {
+            if (s) s->gauges_live.store(false, std::memory_order_release);
+        }
+    };
+
+    static Registry &registry() {
+        static Registry reg;
+        return reg;
+    }
+
+    static Shard &shard() {
+        thread_local Shard *s = nullptr; // plain pointer: no TLS guard on the hot path
+        if (!s) s = register_thread();
+        return *s;
+    }
+
+    static Shard *register_thread() {
+        thread_local Retire retire;
+        Registry &reg = registry();
+        std::lock_guard<std::mutex> lk(reg.m); // once per thread
+        reg.shards.push_back(std::make_unique<Shard>());
+        reg.shards.back()->id = static_cast<std::uint32_t>(reg.shards.size());
+        return retire.s = reg.shards.back().get();
+    }
+};
+
+// --- Scrape endpoint: GET anything on 127.0.0.1:<port> returns all metrics ---
+class MetricsServer {
+public:
+    using Sampler = std::function<double()>;
+
+    explicit MetricsServer(std::uint16_t port) {
+        fd_ = ::socket(AF_INET, SOCK_STREAM, 0);
+        if (fd_ < 0) throw std::runtime_error("metrics: socket failed");
+        int one = 1;
+        ::setsockopt(fd_, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(port);
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        if (::bind(fd_, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) != 0 || ::listen(fd_, 16) != 0) {
+            ::close(fd_);
+            throw std::runtime_error("metrics: cannot listen on port " + std::to_string(port));
+        }
+        socklen_t len = sizeof(addr);
+        ::getsockname(fd_, reinterpret_cast<sockaddr *>(&addr), &len);
+        port_ = ntohs(addr.sin_port);
+        TscClock::calibrate();
+    }
+
+    ~MetricsServer() { stop(); }
+
+    // Extra values sampled on each scrape, e.g. queue depth or arena size.
+    // Register before start().
+    void add_gauge(std::string name, std::string help, Sampler fn) {
+        samplers_.push_back({std::move(name), std::move(help), std::move(fn)});
+    }
+
+    void start() { worker_ = std::thread([this]{ serve(); }); }
+
+    void stop() {
+        if (running_.exchange(false) && worker_.joinable()) worker_.join();
+        if (fd_ >= 0) {
+            ::close(fd_);
+            fd_ = -1;
+        }
+    }
+
+    std::uint16_t port() const { return port_; }
+
+    std::string render() const {
+        static const char *counter_names[] = {
+            "xchange_orders_total", "xchange_cancels_total", "xchange_cancel_misses_total",
+            "xchange_trades_total", "xchange_traded_qty_total", "xchange_rejects_total", "xchange_halts_total"};
+        static const char *gauge_names[] = {
+            "xchange_bid_levels", "xchange_ask_levels", "xchange_resting_orders"};
+        static const char *hist_names[] = {
+            "xchange_queue_latency_seconds", "xchange_match_latency_seconds"};
+
+        EngineMetrics::Totals t = EngineMetrics::collect();
+        std::ostringstream os;
+        for (std::size_t i = 0; i < EngineMetrics::kCounters; ++i)
+            os << "# TYPE " << counter_names[i] << " counter\n" << counter_names[i] << " " << t.counters[i] << "\n";
+        for (std::size_t i = 0; i < EngineMetrics::kGauges; ++i) {
+            os << "# TYPE " << gauge_names[i] << " gauge\n";
+            for (auto const &g : t.gauges)
+                os << gauge_names[i] << "{shard=\"" << g.shard << "\"} " << g.values[i] << "\n";
+        }
+        for (auto const &s : samplers_)
+            os << "# HELP " << s.name << " " << s.help << "\n# TYPE " << s.name << " gauge\n"
+               << s.name << " " << s.fn() << "\n";
+        double sec_per_tick = TscClock::ns_per_tick() * 1e-9;
+        for (std::size_t h = 0; h < EngineMetrics::kHistograms; ++h) {
+            const char *name = hist_names[h];
+            os << "# TYPE " << name << " histogram\n";
+            std::uint64_t cum = 0;
+            std::size_t last = EngineMetrics::kBuckets;
+            while (last > 1 && t.hist[h][last - 1] == 0) --last;
+            for (std::size_t b = 0; b < last; ++b) {
+                cum += t.hist[h][b];
+                os << name << "_bucket{le=\"" << static_cast<double>(std::uint64_t{1} << b) * sec_per_tick
+                   << "\"} " << cum << "\n";
+            }
+            os << name << "_bucket{le=\"+Inf\"} " << cum << "\n"
+               << name << "_sum " << static_cast<double>(t.hist_sum[h]) * sec_per_tick << "\n"
+               << name << "_count " << cum << "\n";
+        }
+        return os.str();
+    }
+
+private:
+    struct NamedSampler {
+        std::string name, help;
+        Sampler fn;
+    };
+
+    void serve() {
+        while (running_) {
+            pollfd p{fd_, POLLIN, 0};
+            if (::poll(&p, 1, 100) <= 0) continue; // re-check running_
+            int c = ::accept(fd_, nullptr, nullptr);
+            if (c < 0) continue;
+            char req[1024];
+            (void)::read(c, req, sizeof(req)); // request line is ignored
+            std::string body = render();
+            std::string resp = "HTTP/1.1 200 OK\r\nContent-Type: text/plain; version=0.0.4\r\n"
+                               "Content-Length: " + std::to_string(body.size()) +
+                               "\r\nConnection: close\r\n\r\n" + body;
+            std::size_t off = 0;
+            while (off < resp.size()) {
+#ifdef MSG_NOSIGNAL
+                ssize_t w = ::send(c, resp.data() + off, resp.size() - off, MSG_NOSIGNAL);
+#else
+                ssize_t w = ::write(c, resp.data() + off, resp.size() - off);
+#endif
+                if (w <= 0) break;
+                off += static_cast<std::size_t>(w);
+            }
+            ::close(c);
+        }
+    }
+
+    int fd_ = -1;
+    std::uint16_t port_ = 0;
+    std::vector<NamedSampler> samplers_;
+    std::atomic<bool> running_{true};
+    std::thread worker_;
+};
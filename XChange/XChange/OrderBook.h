@@ -10,91 +10,141 @@
 // --- Order Book (single-threaded core) ---
 class OrderBook {
 public:
+    // All nodes (levels, queues, id index) come from `mr`; pass a pool over a
+    // HugePageResource to keep a large book on 2MB pages.
+    explicit OrderBook(std::pmr::memory_resource *mr = std::pmr::get_default_resource())
+        : bids_(mr), asks_(mr), hidden_bids_(mr), hidden_asks_(mr), id_index_(mr) {}
+
     // Add a limit order; match immediately; return generated trades.
     std::vector<Trade> add_order(Order order) {
         std::vector<Trade> trades;
-        if (order.side == Side::Buy) {
-            // Cross against best asks
-            while (order.qty > 0 && !asks_.empty()) {
-                auto best_it = asks_.begin(); // lowest ask
-                Price best_px = best_it->first;
-                if (order.price < best_px) break; // not crossable
-                auto &queue = best_it->second; // FIFO at that level
-                while (order.qty > 0 && !queue.empty()) {
-                    auto &resting = queue.front();
-                    Qty traded = std::min(order.qty, resting.qty);
-                    trades.push_back({resting.id, order.id, resting.price, traded});
-                    order.qty   -= traded;
-                    resting.qty -= traded;
-                    if (resting.qty == 0) {
-                        id_index_.erase(resting.id);
-                        queue.pop_front();
-                    } else {
-                        break; // partial on resting; remains in front
-                    }
-                }
-                if (queue.empty()) asks_.erase(best_it);
+        add_order(order, trades);
+        return trades;
+    }
+
+    // Same, but appends to `trades` (not cleared) so a hot loop can reuse one
+    // buffer instead of allocating per order. A Hidden order matches like any
+    // other; its remainder rests behind the lit queue and out of depth.
+    AddResult add_order(Order order, std::vector<Trade> &trades, Display display = Display::Lit) {
+        return match(order, &trades, nullptr, display);
+    }
+
+    // Same, also filling `summary` for the incoming order. With `trades`
+    // null no per-maker trades are produced at all.
+    AddResult add_order(Order order, std::vector<Trade> *trades, ExecutionSummary &summary,
+                        Display display = Display::Lit) {
+        return match(order, trades, &summary, display);
+    }
+
+    // --- Price bands and circuit breaker ---
+    //
+    // Bounds are turned into absolute ticks here, so add_order() pays one
+    // compare per bound. A halt leaves the book as it is and switches it to
+    // auction mode: orders rest without matching (the book may cross) until
+    // resume() uncrosses it.
+
+    void set_price_controls(const PriceControls &pc) {
+        ctl_.band_bps = pc.band_bps;
+        ctl_.move_bps = pc.halt_move_bps;
+        ctl_.window_ns = pc.halt_move_bps ? pc.halt_window.count() : kNoLimit;
+        ctl_.last_px = 0;
+        recenter(pc.reference, ctl_.now_ns);
+    }
+
+    bool halted() const { return ctl_.halted; }
+    void halt() { ctl_.halted = true; }
+
+    // Time (ns) the breaker window is measured in. Never taken from the
+    // order: the matcher stamps each command with its own clock, journals
+    // that, and replicas set it from the record, so every copy re-anchors
+    // at the same command. Stays put until set again.
+    void set_clock(std::int64_t ns) { ctl_.now_ns = ns; }
+
+    // The band check add_order() makes, for callers that must know the
+    // answer before committing to the order (the matcher checks it before
+    // sequencing).
+    bool in_band(Price price) const { return price >= ctl_.band_lo && price <= ctl_.band_hi; }
+
+    // Leaves auction mode: executes everything crossable at the single price
+    // that maximises volume (then minimises imbalance, then is nearest the
+    // reference), in time priority per side, and re-centres the bands on it.
+    // Auction trades report the sell order as maker; hidden orders take part
+    // after the lit queue of their level. Returns that price, or nullopt if
+    // the book was not crossed.
+    std::optional<Price> resume(std::vector<Trade> &trades) {
+        ctl_.halted = false;
+        auto px = uncross_price();
+        if (!px) return std::nullopt;
+        for (;;) {
+            auto [bid_levels, bid_it] = top(bids_, hidden_bids_);
+            auto [ask_levels, ask_it] = top(asks_, hidden_asks_);
+            if (bid_it == bid_levels->end() || ask_it == ask_levels->end() || bid_it->first < *px || ask_it->first > *px)
+                break;
+            Order &bid = bid_it->second.front();
+            Order &ask = ask_it->second.front();
+            Qty traded = std::min(bid.qty, ask.qty);
+            trades.push_back({ask.id, bid.id, *px, traded});
+            bid.qty -= traded;
+            ask.qty -= traded;
+            if (bid.qty == 0) {
+                id_index_.erase(bid.id);
+                bid_it->second.pop_front();
+                if (bid_it->second.empty()) erase_level(*bid_levels, bid_it);
             }
-            if (order.qty > 0) enqueue(order);
-        } else { // Sell
-            // Cross against best bids
-            while (order.qty > 0 && !bids_.empty()) {
-                auto best_it = bids_.begin(); // highest bid (custom comparator)
-                Price best_px = best_it->first;
-                if (order.price > best_px) break; // not crossable
-                auto &queue = best_it->second;
-                while (order.qty > 0 && !queue.empty()) {
-                    auto &resting = queue.front();
-                    Qty traded = std::min(order.qty, resting.qty);
-                    trades.push_back({resting.id, order.id, resting.price, traded});
-                    order.qty   -= traded;
-                    resting.qty -= traded;
-                    if (resting.qty == 0) {
-                        id_index_.erase(resting.id);
-                        queue.pop_front();
-                    } else {
-                        break;
-                    }
-                }
-                if (queue.empty()) bids_.erase(best_it);
+            if (ask.qty == 0) {
+                id_index_.erase(ask.id);
+                ask_it->second.pop_front();
+                if (ask_it->second.empty()) erase_level(*ask_levels, ask_it);
             }
-            if (order.qty > 0) enqueue(order);
         }
-        return trades;
+        ctl_.last_px = *px;
+        recenter(*px, ctl_.now_ns);
+        return px;
     }
 
     bool cancel(OrderId id) {
         auto it = id_index_.find(id);
         if (it == id_index_.end()) return false;
         auto [side, price] = it->second;
-        if (side == Side::Buy) {
-            auto lvl = bids_.find(price);
-            if (lvl == bids_.end()) return false;
-            auto &dq = lvl->second;
-            for (auto itq = dq.begin(); itq != dq.end(); ++itq) {
-                if (itq->id == id) {
-                    dq.erase(itq);
-                    id_index_.erase(it);
-                    if (dq.empty()) bids_.erase(lvl);
-                    return true;
-                }
-            }
-        } else {
-            auto lvl = asks_.find(price);
-            if (lvl == asks_.end()) return false;
-            auto &dq = lvl->second;
-            for (auto itq = dq.begin(); itq != dq.end(); ++itq) {
-                if (itq->id == id) {
-                    dq.erase(itq);
-                    id_index_.erase(it);
-                    if (dq.empty()) asks_.erase(lvl);
-                    return true;
-                }
-            }
+        bool removed = side == Side::Buy ? remove(bids_, price, id) || remove(hidden_bids_, price, id)
+                                         : remove(asks_, price, id) || remove(hidden_asks_, price, id);
+        if (removed) id_index_.erase(it);
+        return removed;
+    }
+
+    // Cancel/replace in one step: cancels `orig` and, only if it was resting,
+    // adds `order` at the back of its level and returns what add_order()
+    // did. nullopt (book unchanged) if `orig` is not resting. An `order`
+    // outside the band is Rejected before the cancel, so `orig` stays.
+    std::optional<AddResult> replace(OrderId orig, Order order, std::vector<Trade> &trades,
+                                     Display display = Display::Lit) {
+        return cancel_then_match(orig, order, &trades, nullptr, display);
+    }
+
+    // Same, also filling `summary` for `order`, as add_order() does.
+    std::optional<AddResult> replace(OrderId orig, Order order, std::vector<Trade> *trades, ExecutionSummary &summary,
+                                     Display display = Display::Lit) {
+        return cancel_then_match(orig, order, trades, &summary, display);
+    }
+
+    // Applies one sequenced command as the matcher did: how a standby, a
+    // replay or a backtest rebuilds the book from the stream. Rejects are
+    // never sequenced, so every command here is one the matcher took.
+    void apply(const Command &c, std::vector<Trade> &trades) {
+        set_clock(c.clock_ns);
+        switch (c.type) {
+        case Command::Type::NewOrder: add_order(c.order, trades, c.display); break;
+        case Command::Type::Cancel:   cancel(c.order.id); break;
+        case Command::Type::Replace:  replace(c.replaces, c.order, trades, c.display); break;
+        case Command::Type::Controls:
+            set_price_controls(command_controls(c));
+            if (c.controls.halt) halt();
+            break;
+        case Command::Type::Resume:   resume(trades); break;
         }
-        return false;
     }
 
+    // Displayed BBO; hidden orders never show here.
     std::optional<Price> best_bid() const {
         if (bids_.empty()) return std::nullopt;
         return bids_.begin()->first;
@@ -104,6 +154,52 @@ public:
         return asks_.begin()->first;
     }
 
+    std::size_t bid_levels() const { return bids_.size(); }
+    std::size_t ask_levels() const { return asks_.size(); }
+    std::size_t order_count() const { return id_index_.size(); } // lit and hidden
+
+    // Sizes the id index for `orders` resting orders so it never rehashes
+    // below that.
+    void reserve(std::size_t orders) { id_index_.reserve(orders); }
+
+    // Level a resting order sits on, if it is still resting.
+    std::optional<std::pair<Side, Price>> locate(OrderId id) const {
+        auto it = id_index_.find(id);
+        if (it == id_index_.end()) return std::nullopt;
+        return it->second;
+    }
+
+    // Visits resting orders in priority order: asks low→high, then bids
+    // high→low, FIFO within a level. f(side, price, id, qty).
+    template <typename F>
+    void for_each_resting(F &&f) const {
+        for (auto const & [px, q] : asks_)
+            for (auto const &o : q) f(Side::Sell, px, o.id, o.qty);
+        for (auto const & [px, q] : bids_)
+            for (auto const &o : q) f(Side::Buy, px, o.id, o.qty);
+    }
+
+    // Same for hidden orders, which the views above and below leave out.
+    template <typename F>
+    void for_each_hidden(F &&f) const {
+        for (auto const & [px, q] : hidden_asks_)
+            for (auto const &o : q) f(Side::Sell, px, o.id, o.qty);
+        for (auto const & [px, q] : hidden_bids_)
+            for (auto const &o : q) f(Side::Buy, px, o.id, o.qty);
+    }
+
+    // Visits one level's (lit) queue in FIFO order. f(id, qty).
+    template <typename F>
+    void for_each_at_level(Side side, Price price, F &&f) const {
+        auto visit = [&](auto const &levels) {
+            auto lvl = levels.find(price);
+            if (lvl == levels.end()) return;
+            for (auto const &o : lvl->second) f(o.id, o.qty);
+        };
+        if (side == Side::Buy) visit(bids_);
+        else visit(asks_);
+    }
+
     void print_book(std::ostream &os = std::cout) const {
         os << "\n===== ORDER BOOK =====\n";
         os << " Asks (low→high)\n";
@@ -122,21 +218,262 @@ public:
     }
 
 private:
+    // Shared by the add_order() overloads. A book that has never held a
+    // hidden order on the opposite side runs the lit-only crossing loop.
+    AddResult match(Order order, std::vector<Trade> *trades, ExecutionSummary *summary, Display display) {
+        if (summary) *summary = ExecutionSummary{order.id, order.side};
+        if (!in_band(order.price)) return AddResult::Rejected;
+        if (ctl_.halted) {
+            if (summary) summary->leaves_qty = order.qty;
+            if (order.qty > 0) enqueue(order, display);
+            return AddResult::Accepted;
+        }
+        if (ctl_.now_ns - ctl_.anchor_ns > ctl_.window_ns) recenter_breaker(ctl_.last_px, ctl_.now_ns);
+        AddResult result;
+        if (order.side == Side::Buy) // cross against best asks
+            result = hidden_asks_.empty() ? cross<false>(order, asks_, hidden_asks_, trades, summary)
+                                          : cross<true>(order, asks_, hidden_asks_, trades, summary);
+        else // cross against best bids
+            result = hidden_bids_.empty() ? cross<false>(order, bids_, hidden_bids_, trades, summary)
+                                          : cross<true>(order, bids_, hidden_bids_, trades, summary);
+        if (order.qty > 0) enqueue(order, display);
+        if (summary) summary->leaves_qty = order.qty;
+        return result;
+    }
+
+    // Shared by the replace() overloads.
+    std::optional<AddResult> cancel_then_match(OrderId orig, Order order, std::vector<Trade> *trades,
+                                               ExecutionSummary *summary, Display display) {
+        if (!id_index_.contains(orig)) return std::nullopt;
+        if (!in_band(order.price)) {
+            if (summary) *summary = ExecutionSummary{order.id, order.side};
+            return AddResult::Rejected;
+        }
+        cancel(orig);
+        return match(order, trades, summary, display);
+    }
+
+    // Walks the opposite side best price first. With Hidden, a level is the
+    // better of the lit and hidden tops, and at a shared price the lit queue
+    // is exhausted before the hidden one. Without it the hidden levels are
+    // never looked at.
+    template <bool Hidden, typename Levels>
+    AddResult cross(Order &order, Levels &lit, Levels &hidden, std::vector<Trade> *trades, ExecutionSummary *summary) {
+        constexpr bool buy = std::is_same_v<Levels, AskLevels>;
+        while (order.qty > 0) {
+            auto lit_it = lit.begin();
+            Price best_px;
+            if constexpr (Hidden) {
+                auto [levels, it] = top(lit, hidden);
+                if (it == levels->end()) break;
+                best_px = it->first;
+            } else {
+                if (lit_it == lit.end()) break;
+                best_px = lit_it->first;
+            }
+            if (buy ? order.price < best_px : order.price > best_px) break; // not crossable
+            if (buy ? best_px > ctl_.halt_hi : best_px < ctl_.halt_lo) {
+                ctl_.halted = true;
+                return AddResult::Halted;
+            }
+            ctl_.last_px = best_px;
+            if (summary) ++summary->levels_touched;
+            if constexpr (Hidden) {
+                if (lit_it != lit.end() && lit_it->first == best_px) take(lit, lit_it, order, trades, summary);
+                auto hid_it = hidden.begin();
+                if (order.qty > 0 && hid_it != hidden.end() && hid_it->first == best_px)
+                    take(hidden, hid_it, order, trades, summary);
+            } else {
+                take(lit, lit_it, order, trades, summary);
+            }
+        }
+        return AddResult::Accepted;
+    }
+
+    // Fills `order` from the FIFO at `level`, dropping the level once empty.
+    template <typename Levels>
+    void take(Levels &levels, typename Levels::iterator level, Order &order, std::vector<Trade> *trades,
+              ExecutionSummary *summary) {
+        auto &queue = level->second;
+        while (order.qty > 0 && !queue.empty()) {
+            auto &resting = queue.front();
+            Qty traded = std::min(order.qty, resting.qty);
+            if (trades) trades->push_back({resting.id, order.id, resting.price, traded});
+            if (summary) summary->record(resting.price, traded);
+            order.qty   -= traded;
+            resting.qty -= traded;
+            if (resting.qty == 0) {
+                id_index_.erase(resting.id);
+                queue.pop_front();
+            } else {
+                break; // partial on resting; remains in front
+            }
+        }
+        if (queue.empty()) erase_level(levels, level);
+    }
+
+    // Best level of one side across its lit and hidden maps, lit on a tie.
+    // Returns the map holding it and its iterator (that map's end() if the
+    // side is empty).
+    template <typename Levels>
+    static std::pair<Levels *, decltype(std::declval<Levels &>().begin())> top(Levels &lit, Levels &hidden) {
+        if (hidden.empty() || (!lit.empty() && !lit.key_comp()(hidden.begin()->first, lit.begin()->first)))
+            return {&lit, lit.begin()};
+        return {&hidden, hidden.begin()};
+    }
+
+    template <typename Levels>
+    bool remove(Levels &levels, Price price, OrderId id) {
+        auto lvl = levels.find(price);
+        if (lvl == levels.end()) return false;
+        auto &dq = lvl->second;
+        for (auto itq = dq.begin(); itq != dq.end(); ++itq) {
+            if (itq->id == id) {
+                dq.erase(itq);
+                if (dq.empty()) erase_level(levels, lvl);
+                return true;
+            }
+        }
+        return false;
+    }
+
     // Highest bid first
-    using BidLevels = std::map<Price, std::deque<Order>, std::greater<>>;
+    using BidLevels = std::pmr::map<Price, std::pmr::deque<Order>, std::greater<>>;
     // Lowest ask first
-    using AskLevels = std::map<Price, std::deque<Order>>;
+    using AskLevels = std::pmr::map<Price, std::pmr::deque<Order>>;
 
-    BidLevels bids_{};
-    AskLevels asks_{};
-    std::unordered_map<OrderId, std::pair<Side, Price>> id_index_{}; // id -> (side, price)
+    BidLevels bids_;
+    AskLevels asks_;
+    BidLevels hidden_bids_; // non-displayed, matched after the lit queue at each price
+    AskLevels hidden_asks_;
+    std::pmr::unordered_map<OrderId, std::pair<Side, Price>> id_index_; // id -> (side, price)
 
-    void enqueue(const Order &order) {
-        if (order.side == Side::Buy) {
-            bids_[order.price].push_back(order);
-        } else {
-            asks_[order.price].push_back(order);
+    // Level the last passive order joined. Runs of passive orders at one
+    // price (common when a batch is drained) skip the map lookup. Map nodes
+    // are stable, so the pointer is good until that level is erased.
+    // A copied or moved-to book has levels of its own, so its hint starts
+    // empty rather than pointing into the source's. A move clears the
+    // source's too: the level it pointed at now belongs to the destination.
+    struct InsertHint {
+        std::pmr::deque<Order> *queue = nullptr;
+        Side  side{};
+        Price price{};
+
+        InsertHint() = default;
+        InsertHint(const InsertHint &) {}
+        InsertHint(InsertHint &&o) noexcept { o.queue = nullptr; }
+        InsertHint &operator=(const InsertHint &) {
+            queue = nullptr;
+            return *this;
+        }
+        InsertHint &operator=(InsertHint &&o) noexcept {
+            queue = nullptr;
+            o.queue = nullptr;
+            return *this;
+        }
+    } hint_{};
+
+    static constexpr std::int64_t kNoLimit = std::numeric_limits<std::int64_t>::max();
+
+    // Precomputed tick bounds; "off" is the widest range, so the checks in
+    // match() never branch on configuration.
+    struct Controls {
+        Price         band_lo = std::numeric_limits<Price>::min();
+        Price         band_hi = std::numeric_limits<Price>::max();
+        Price         halt_lo = std::numeric_limits<Price>::min();
+        Price         halt_hi = std::numeric_limits<Price>::max();
+        std::int64_t  band_bps = 0, move_bps = 0;
+        std::int64_t  window_ns = kNoLimit;
+        std::int64_t  anchor_ns = 0; // clock the breaker window started at
+        std::int64_t  now_ns = 0;    // set_clock()
+        Price         reference = 0;
+        Price         last_px = 0;   // last trade
+        bool          halted = false;
+    } ctl_{};
+
+    static std::pair<Price, Price> bounds(Price ref, std::int64_t bps) {
+        if (bps == 0) return {std::numeric_limits<Price>::min(), std::numeric_limits<Price>::max()};
+        Price d = ref * bps / 10000;
+        return {ref - d, ref + d};
+    }
+
+    void recenter(Price reference, std::int64_t ts_ns) {
+        ctl_.reference = reference;
+        std::tie(ctl_.band_lo, ctl_.band_hi) = bounds(reference, ctl_.band_bps);
+        recenter_breaker(reference, ts_ns);
+    }
+
+    void recenter_breaker(Price anchor, std::int64_t ts_ns) {
+        if (anchor == 0) anchor = ctl_.reference; // no trade yet
+        std::tie(ctl_.halt_lo, ctl_.halt_hi) = bounds(anchor, ctl_.move_bps);
+        ctl_.anchor_ns = ts_ns;
+    }
+
+    // Single price maximising executed volume over the crossed part of the
+    // book; ties go to the smaller imbalance, then to the reference.
+    std::optional<Price> uncross_price() const {
+        auto [bid_levels, bid_top] = top(bids_, hidden_bids_);
+        auto [ask_levels, ask_top] = top(asks_, hidden_asks_);
+        if (bid_top == bid_levels->end() || ask_top == ask_levels->end() || bid_top->first < ask_top->first)
+            return std::nullopt;
+        Price hi = bid_top->first, lo = ask_top->first;
+        std::vector<std::pair<Price, Qty>> bid_qty, ask_qty; // lit and hidden, per level
+        auto collect = [](auto const &levels, auto crossed, auto &out) {
+            for (auto const &[px, q] : levels) {
+                if (!crossed(px)) break;
+                Qty t = 0;
+                for (auto const &o : q) t += o.qty;
+                out.emplace_back(px, t);
+            }
+        };
+        auto bid_crossed = [lo](Price px) { return px >= lo; };
+        auto ask_crossed = [hi](Price px) { return px <= hi; };
+        collect(bids_, bid_crossed, bid_qty);
+        collect(hidden_bids_, bid_crossed, bid_qty);
+        collect(asks_, ask_crossed, ask_qty);
+        collect(hidden_asks_, ask_crossed, ask_qty);
+        std::vector<Price> cands;
+        for (auto const &b : bid_qty) cands.push_back(b.first);
+        for (auto const &a : ask_qty) cands.push_back(a.first);
+        std::sort(cands.begin(), cands.end());
+        cands.erase(std::unique(cands.begin(), cands.end()), cands.end());
+
+        std::optional<Price> best;
+        Qty best_vol = -1, best_imb = 0;
+        for (Price p : cands) {
+            Qty demand = 0, supply = 0;
+            for (auto const &[px, t] : bid_qty) if (px >= p) demand += t;
+            for (auto const &[px, t] : ask_qty) if (px <= p) supply += t;
+            Qty vol = std::min(demand, supply);
+            Qty imb = demand > supply ? demand - supply : supply - demand;
+            auto dist = [&](Price x) { return x > ctl_.reference ? x - ctl_.reference : ctl_.reference - x; };
+            if (vol > best_vol || (vol == best_vol && (imb < best_imb || (imb == best_imb && dist(p) < dist(*best))))) {
+                best = p;
+                best_vol = vol;
+                best_imb = imb;
+            }
+        }
+        return best;
+    }
+
+    template <typename Levels, typename It>
+    void erase_level(Levels &levels, It it) {
+        if (hint_.queue == &it->second) hint_.queue = nullptr;
+        levels.erase(it);
+    }
+
+    void enqueue(const Order &order, Display display) {
+        if (display == Display::Hidden) {
+            (order.side == Side::Buy ? hidden_bids_[order.price] : hidden_asks_[order.price]).push_back(order);
+            id_index_[order.id] = {order.side, order.price};
+            return;
+        }
+        if (!hint_.queue || hint_.side != order.side || hint_.price != order.price) {
+            hint_.queue = order.side == Side::Buy ? &bids_[order.price] : &asks_[order.price];
+            hint_.side = order.side;
+            hint_.price = order.price;
         }
+        hint_.queue->push_back(order);
         id_index_[order.id] = {order.side, order.price};
     }
 };
@@ -0,0 +1,219 @@
+//
+//  Pegs.h
+//  XChange
+//
+//  Created by Williams on 17/10/2026.
+//
+#pragma once
+#include "OrderBook.h"
+
+// --- Primary-peg and midpoint-peg orders over a lit OrderBook ---
+//
+// Pegged orders never sit in the lit book. Primary pegs are kept in groups
+// keyed by their offset from the same-side touch (buys: bid + offset with
+// offset <= 0; sells: ask + offset with offset >= 0), FIFO within a group.
+// A group's price is derived from the lit BBO when it is needed, so a BBO
+// change reprices every group at once and no order is ever reinserted.
+// Midpoint pegs sit in one FIFO per side at (bid + ask) / 2, executable only
+// while that is a whole tick.
+//
+// An incoming lit order crosses, in price order, the lit book, the opposite
+// midpoint pool and the opposite peg groups. Peg prices are taken from the
+// BBO as it stood when the order arrived (that is where the pegs were
+// resting). At equal prices lit goes first, then midpoint, then pegs.
+// Resting midpoint buys and sells that become crossable after a BBO change
+// are matched at the end of the call that changed it.
+
+enum class PegType : std::uint8_t { Primary, Midpoint };
+
+class PeggedOrderBook {
+public:
+    // --- Lit orders ---
+
+    void add_order(Order o, std::vector<Trade> &trades) {
+        if (o.side == Side::Buy) cross(o, book_.best_ask(), sell_pegs_, mid_sells_, trades);
+        else cross(o, book_.best_bid(), buy_pegs_, mid_buys_, trades);
+        if (o.qty > 0) book_.add_order(o, trades); // rests: nothing left crosses it
+        cross_midpoint(trades);
+    }
+
+    // --- Pegged orders; o.price is ignored ---
+
+    // Midpoint pegs first cross resting midpoint orders of the other side.
+    // Returns false (and does nothing) for a primary peg whose offset would
+    // put it through its own touch.
+    bool add_peg(Order o, PegType type, Price offset, std::vector<Trade> &trades) {
+        bool buy = o.side == Side::Buy;
+        if (type == PegType::Midpoint) {
+            if (auto mid = midpoint(book_.best_bid(), book_.best_ask())) {
+                PegQueue &opp = buy ? mid_sells_ : mid_buys_;
+                if (purge(opp)) o.qty = take_from(opp, o.id, *mid, o.qty, trades);
+            }
+            if (o.qty > 0) rest(buy ? mid_buys_ : mid_sells_, o);
+            return true;
+        }
+        if (buy ? offset > 0 : offset < 0) return false;
+        PegQueue &q = buy ? buy_pegs_[offset] : sell_pegs_[offset];
+        if (o.qty > 0) rest(q, o);
+        return true;
+    }
+
+    bool cancel(OrderId id, std::vector<Trade> &trades) {
+        if (book_.cancel(id)) {
+            cross_midpoint(trades); // the BBO may have moved
+            return true;
+        }
+        auto it = pegs_.find(id);
+        if (it == pegs_.end()) return false;
+        it->second->qty = 0; // tombstone; popped when reached
+        pegs_.erase(it);
+        return true;
+    }
+
+    // --- Views ---
+
+    std::optional<Price> best_bid() const { return book_.best_bid(); }
+    std::optional<Price> best_ask() const { return book_.best_ask(); }
+    std::optional<Price> midpoint() const { return midpoint(book_.best_bid(), book_.best_ask()); }
+
+    // Current price of a primary peg group: one add, whatever its size.
+    std::optional<Price> peg_price(Side side, Price offset) const {
+        auto ref = side == Side::Buy ? book_.best_bid() : book_.best_ask();
+        if (!ref) return std::nullopt;
+        return *ref + offset;
+    }
+
+    // Visits live primary-peg groups best first: f(offset, price, qty, orders).
+    // `price` is nullopt while the touch it follows is empty.
+    template <typename F>
+    void for_each_peg_group(Side side, F &&f) const {
+        auto visit = [&](auto const &groups) {
+            for (auto const &[off, q] : groups) {
+                Qty qty = 0;
+                std::size_t n = 0;
+                for (auto const &p : q)
+                    if (p.qty > 0) { qty += p.qty; ++n; }
+                if (n) f(off, peg_price(side, off), qty, n);
+            }
+        };
+        if (side == Side::Buy) visit(buy_pegs_);
+        else visit(sell_pegs_);
+    }
+
+    Qty midpoint_qty(Side side) const {
+        Qty qty = 0;
+        for (auto const &p : side == Side::Buy ? mid_buys_ : mid_sells_) qty += p.qty;
+        return qty;
+    }
+
+    std::size_t peg_count() const { return pegs_.size(); }
+    const OrderBook &lit() const { return book_; }
+
+private:
+    struct PegOrder {
+        OrderId id;
+        Qty     qty; // 0 = cancelled
+    };
+    // References into a deque survive push_back/pop_front, so the index can
+    // point straight at the order.
+    using PegQueue = std::deque<PegOrder>;
+    // Keyed by offset, best first: buys highest, sells lowest.
+    using BuyPegs = std::map<Price, PegQueue, std::greater<>>;
+    using SellPegs = std::map<Price, PegQueue>;
+
+    static std::optional<Price> midpoint(std::optional<Price> bid, std::optional<Price> ask) {
+        if (!bid || !ask || ((*bid + *ask) & 1)) return std::nullopt;
+        return (*bid + *ask) / 2;
+    }
+
+    // Takes liquidity for `o` in price order from the lit book, the midpoint
+    // pool and the peg groups opposite it. Peg and midpoint prices use the
+    // BBO as it was on arrival; `ref` is the opposite touch.
+    template <typename Groups>
+    void cross(Order &o, std::optional<Price> ref, Groups &groups, PegQueue &mids, std::vector<Trade> &trades) {
+        bool buy = o.side == Side::Buy;
+        auto mid = midpoint(book_.best_bid(), book_.best_ask());
+        auto better = [buy](Price a, Price b) { return buy ? a < b : a > b; };
+        while (o.qty > 0) {
+            auto lit = buy ? book_.best_ask() : book_.best_bid();
+            enum { None, Lit, Mid, Peg } pick = None;
+            Price px{};
+            if (lit) { pick = Lit; px = *lit; }
+            if (mid && purge(mids) && (pick == None || better(*mid, px))) { pick = Mid; px = *mid; }
+            if (ref && purge_groups(groups)) {
+                Price peg = *ref + groups.begin()->first;
+                if (pick == None || better(peg, px)) { pick = Peg; px = peg; }
+            }
+            if (pick == None || better(o.price, px)) return; // not crossable
+
+            if (pick == Lit) {
+                Qty level = 0;
+                book_.for_each_at_level(buy ? Side::Sell : Side::Buy, px, [&](OrderId, Qty q) { level += q; });
+                Qty take = std::min(o.qty, level);
+                book_.add_order(Order{ o.id, o.side, px, take, o.ts }, trades); // fills exactly at px
+                o.qty -= take;
+            } else if (pick == Mid) {
+                o.qty = take_from(mids, o.id, px, o.qty, trades);
+            } else {
+                auto g = groups.begin();
+                o.qty = take_from(g->second, o.id, px, o.qty, trades);
+                if (!purge(g->second)) groups.erase(g);
+            }
+        }
+    }
+
+    void rest(PegQueue &q, const Order &o) {
+        q.push_back({o.id, o.qty});
+        pegs_[o.id] = &q.back();
+    }
+
+    // Drops cancelled orders at the front; true if anything live remains.
+    static bool purge(PegQueue &q) {
+        while (!q.empty() && q.front().qty == 0) q.pop_front();
+        return !q.empty();
+    }
+
+    template <typename Groups>
+    static bool purge_groups(Groups &groups) {
+        while (!groups.empty() && !purge(groups.begin()->second)) groups.erase(groups.begin());
+        return !groups.empty();
+    }
+
+    // Fills up to `qty` from the front of `q` at `px`; returns what is left.
+    Qty take_from(PegQueue &q, OrderId taker, Price px, Qty qty, std::vector<Trade> &trades) {
+        while (qty > 0 && purge(q)) {
+            PegOrder &maker = q.front();
+            Qty traded = std::min(qty, maker.qty);
+            trades.push_back({maker.id, taker, px, traded});
+            qty -= traded;
+            maker.qty -= traded;
+            if (maker.qty == 0) {
+                pegs_.erase(maker.id);
+                q.pop_front();
+            }
+        }
+        return qty;
+    }
+
+    // Resting midpoint buys vs sells once the midpoint is a tick again; the
+    // sell is reported as maker.
+    void cross_midpoint(std::vector<Trade> &trades) {
+        auto mid = midpoint();
+        if (!mid) return;
+        while (purge(mid_buys_) && purge(mid_sells_)) {
+            PegOrder &b = mid_buys_.front(), &s = mid_sells_.front();
+            Qty traded = std::min(b.qty, s.qty);
+            trades.push_back({s.id, b.id, *mid, traded});
+            b.qty -= traded;
+            s.qty -= traded;
+            if (b.qty == 0) { pegs_.erase(b.id); mid_buys_.pop_front(); }
+            if (s.qty == 0) { pegs_.erase(s.id); mid_sells_.pop_front(); }
+        }
+    }
+
+    OrderBook book_;
+    BuyPegs buy_pegs_;
+    SellPegs sell_pegs_;
+    PegQueue mid_buys_, mid_sells_;
+    std::unordered_map<OrderId, PegOrder *> pegs_; // live pegs only
+};
@@ -0,0 +1,505 @@
+//
+//  PersistentOrderBook.h
+//  XChange
+//
+//  Created by Williams on 17/10/2026.
+//
+#pragma once
+#include "Journal.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <type_traits>
+#include <unistd.h>
+
+// --- Memory-mapped order book (restart without rebuilding) ---
+//
+// Same matching semantics as OrderBook, but every byte of state lives in one
+// mapped file: header, order pool, level pool, id index and an undo log. All
+// links are 32-bit indices into those arrays, so the file can be remapped at
+// any address.
+//
+// Consistency marker: each command runs between begin_seq = seq and
+// applied_seq = seq. Every store in between first logs the old value, so if
+// the process dies mid-command the next open() finds begin_seq != applied_seq,
+// undoes the partial command and the caller rolls forward from the journal.
+//
+// A clean close seals the image with a CRC32C over the header and the live
+// parts of the pools and index; the next open verifies it, so a file damaged
+// while at rest is refused instead of matched against. Any command clears
+// the seal first.
+
+struct PersistentBookConfig {
+    std::uint32_t max_orders{1u << 20};
+    std::uint32_t max_levels{1u << 14};
+    std::uint32_t max_undo{1u << 16};   // stores a single command may make
+};
+
+class PersistentOrderBook {
+public:
+    PersistentOrderBook(const std::string &path, PersistentBookConfig cfg = {}) {
+        fd_ = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+        if (fd_ < 0) throw std::runtime_error("book: cannot open " + path);
+        struct stat st{};
+        if (::fstat(fd_, &st) != 0) {
+            ::close(fd_);
+            throw std::runtime_error("book: cannot stat " + path);
+        }
+        bool fresh = st.st_size == 0;
+        if (!fresh) {
+            // Geometry comes from the file, not the caller.
+            Header h{};
+            if (::pread(fd_, &h, sizeof(h), 0) != static_cast<ssize_t>(sizeof(h))
+                || std::memcmp(h.magic, kMagic, sizeof(kMagic)) != 0 || h.version != kVersion) {
+                ::close(fd_);
+                throw std::runtime_error("book: bad header in " + path);
+            }
+            cfg = {h.max_orders, h.max_levels, h.max_undo};
+        }
+        Layout lay = layout(cfg);
+        if (!fresh && static_cast<std::uint64_t>(st.st_size) < lay.total) { // mapping past EOF would SIGBUS on touch
+            ::close(fd_);
+            throw std::runtime_error("book: " + path + " is shorter than its header says");
+        }
+        if (fresh && ::ftruncate(fd_, static_cast<off_t>(lay.total)) != 0) {
+            ::close(fd_);
+            throw std::runtime_error("book: cannot size " + path);
+        }
+        void *p = ::mmap(nullptr, lay.total, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+        if (p == MAP_FAILED) {
+            ::close(fd_);
+            throw std::runtime_error("book: cannot map " + path);
+        }
+        size_ = lay.total;
+        base_ = static_cast<char *>(p);
+        hdr_    = reinterpret_cast<Header *>(base_);
+        orders_ = reinterpret_cast<OrderNode *>(base_ + lay.orders);
+        levels_ = reinterpret_cast<LevelNode *>(base_ + lay.levels);
+        slots_  = reinterpret_cast<Slot *>(base_ + lay.slots);
+        undo_   = reinterpret_cast<UndoEntry *>(base_ + lay.undo);
+
+        if (fresh) {
+            // ftruncate zero-fills, so only non-zero fields need setting.
+            hdr_->version = kVersion;
+            hdr_->max_orders = cfg.max_orders;
+            hdr_->max_levels = cfg.max_levels;
+            hdr_->max_undo = cfg.max_undo;
+            hdr_->slot_mask = lay.slot_count - 1;
+            hdr_->free_order = kNil;
+            hdr_->free_level = kNil;
+            hdr_->best[0] = hdr_->best[1] = kNil;
+            std::atomic_signal_fence(std::memory_order_release);
+            std::memcpy(hdr_->magic, kMagic, sizeof(kMagic));
+        } else if (hdr_->begin_seq != hdr_->applied_seq) {
+            rollback();
+            recovered_partial_ = true;
+        } else if (hdr_->sealed) {
+            if (hdr_->sealed_crc != image_crc()) {
+                ::munmap(base_, size_);
+                ::close(fd_);
+                throw std::runtime_error("book: checksum mismatch in " + path);
+            }
+            verified_ = true;
+        }
+    }
+
+    ~PersistentOrderBook() {
+        if (base_) {
+            seal();
+            ::munmap(base_, size_);
+        }
+        if (fd_ >= 0) ::close(fd_);
+    }
+    PersistentOrderBook(const PersistentOrderBook &) = delete;
+    PersistentOrderBook &operator=(const PersistentOrderBook &) = delete;
+
+    // True if open found a partially applied command (it has been undone).
+    bool recovered_partial() const { return recovered_partial_; }
+    // True if open found a seal and the image matched it.
+    bool verified() const { return verified_; }
+    SeqNo applied_seq() const { return hdr_->applied_seq; }
+
+    // Add a limit order; match immediately; return generated trades.
+    std::vector<Trade> add_order(Order order) { return apply_new(order, hdr_->applied_seq + 1); }
+
+    bool cancel(OrderId id) { return apply_cancel(id, hdr_->applied_seq + 1); }
+
+    // Applies a sequenced command; commands at or below applied_seq() are
+    // already in the book and skipped.
+    std::vector<Trade> apply(const Command &c) {
+        if (c.seq <= hdr_->applied_seq) return {};
+        if (c.type == Command::Type::Cancel) {
+            apply_cancel(c.order.id, c.seq);
+            return {};
+        }
+        if (c.display == Display::Hidden) throw std::runtime_error("book: hidden orders are not supported");
+        if (c.type == Command::Type::Replace) throw std::runtime_error("book: replace is not supported");
+        if (c.type == Command::Type::Controls || c.type == Command::Type::Resume)
+            throw std::runtime_error("book: price controls are not supported");
+        return apply_new(c.order, c.seq);
+    }
+
+    // Replays journal records newer than applied_seq(); returns how many.
+    // Takes a JournalReader or a CompressedJournalReader.
+    template <typename Reader>
+    std::size_t roll_forward(Reader &journal) {
+        std::size_t n = 0;
+        Command c;
+        while (journal.next(c)) {
+            if (c.seq <= hdr_->applied_seq) continue;
+            apply(c);
+            ++n;
+        }
+        return n;
+    }
+
+    // Asks the OS to write dirty pages back (only needed to survive an OS
+    // crash; a process crash keeps the page cache).
+    void flush() { ::msync(base_, size_, MS_ASYNC); }
+
+    std::optional<Price> best_bid() const { return best(Side::Buy); }
+    std::optional<Price> best_ask() const { return best(Side::Sell); }
+
+    // Same order and signature as OrderBook::for_each_resting.
+    template <typename F>
+    void for_each_resting(F &&f) const {
+        for (Side s : {Side::Sell, Side::Buy})
+            for (std::uint32_t li = hdr_->best[static_cast<int>(s)]; li != kNil; li = levels_[li].worse)
+                for (std::uint32_t oi = levels_[li].head; oi != kNil; oi = orders_[oi].next)
+                    f(s, levels_[li].price, orders_[oi].id, orders_[oi].qty);
+    }
+
+    template <typename F>
+    void for_each_at_level(Side side, Price price, F &&f) const {
+        for (std::uint32_t li = hdr_->best[static_cast<int>(side)]; li != kNil; li = levels_[li].worse) {
+            if (levels_[li].price != price) continue;
+            for (std::uint32_t oi = levels_[li].head; oi != kNil; oi = orders_[oi].next)
+                f(orders_[oi].id, orders_[oi].qty);
+            return;
+        }
+    }
+
+    void print_book(std::ostream &os = std::cout) const {
+        os << "\n===== ORDER BOOK =====\n";
+        os << " Asks (low→high)\n";
+        print_side(os, Side::Sell);
+        os << " Bids (high→low)\n";
+        print_side(os, Side::Buy);
+        os << "======================\n";
+    }
+
+private:
+    static constexpr std::uint32_t kNil = 0xffffffffu;
+    static constexpr char kMagic[8] = {'X', 'C', 'B', 'O', 'O', 'K', '0', '1'};
+    static constexpr std::uint32_t kVersion = 2; // 2: sealed image checksum
+
+    struct Header {
+        char          magic[8];
+        std::uint32_t version;
+        std::uint32_t max_orders, max_levels, max_undo;
+        std::uint32_t slot_mask;
+        std::uint32_t free_order, free_level;   // free-list heads
+        std::uint32_t used_orders, used_levels; // bump high-water marks
+        std::uint32_t best[2];                  // best level per Side
+        std::uint32_t undo_count;
+        SeqNo         begin_seq;
+        SeqNo         applied_seq;
+        std::uint32_t sealed;       // image unchanged since sealed_crc was taken
+        std::uint32_t sealed_crc;
+    };
+    struct OrderNode {
+        OrderId       id;
+        Price         price;
+        Qty           qty;
+        std::int64_t  ts;
+        std::uint32_t prev, next;  // FIFO within level; next doubles as free link
+        std::uint32_t level;
+        std::uint8_t  side;
+    };
+    struct LevelNode {
+        Price         price;
+        std::uint32_t head, tail;     // order FIFO
+        std::uint32_t better, worse;  // neighbours; worse doubles as free link
+    };
+    struct Slot {
+        OrderId       id;
+        std::uint32_t node;
+        std::uint32_t used;
+    };
+    struct UndoEntry {
+        std::uint64_t offset;
+        std::uint64_t old;
+        std::uint32_t size;
+    };
+
+    struct Layout {
+        std::size_t orders, levels, slots, undo, total;
+        std::uint32_t slot_count;
+    };
+    static Layout layout(const PersistentBookConfig &cfg) {
+        auto align = [](std::size_t n){ return (n + 63) & ~std::size_t{63}; };
+        Layout l{};
+        l.slot_count = 1;
+        while (l.slot_count < 2 * cfg.max_orders) l.slot_count <<= 1; // load <= 0.5
+        l.orders = align(sizeof(Header));
+        l.levels = align(l.orders + sizeof(OrderNode) * cfg.max_orders);
+        l.slots  = align(l.levels + sizeof(LevelNode) * cfg.max_levels);
+        l.undo   = align(l.slots + sizeof(Slot) * l.slot_count);
+        l.total  = align(l.undo + sizeof(UndoEntry) * cfg.max_undo);
+        return l;
+    }
+
+    // --- Undo-logged stores ---
+    template <typename T>
+    void set(T &field, T value) {
+        static_assert(std::is_trivially_copyable_v<T> && sizeof(T) <= 8);
+        if (hdr_->undo_count == hdr_->max_undo) fail("book: undo log full");
+        UndoEntry &u = undo_[hdr_->undo_count];
+        u.offset = static_cast<std::uint64_t>(reinterpret_cast<char *>(&field) - base_);
+        u.size = sizeof(T);
+        std::memcpy(&u.old, &field, sizeof(T));
+        std::atomic_signal_fence(std::memory_order_release); // log before count
+        hdr_->undo_count = hdr_->undo_count + 1;
+        std::atomic_signal_fence(std::memory_order_release); // count before store
+        field = value;
+    }
+
+    void begin(SeqNo seq) {
+        if (hdr_->sealed) {
+            hdr_->sealed = 0;
+            std::atomic_signal_fence(std::memory_order_release);
+        }
+        hdr_->undo_count = 0;
+        std::atomic_signal_fence(std::memory_order_release);
+        hdr_->begin_seq = seq;
+        std::atomic_signal_fence(std::memory_order_release);
+    }
+
+    // Header (seal fields excluded), live orders and levels, and the index.
+    // The undo log is dead once a command commits, so it is left out.
+    std::uint32_t image_crc() const {
+        std::uint32_t crc = crc32c(base_, offsetof(Header, sealed));
+        crc = crc32c(orders_, sizeof(OrderNode) * hdr_->used_orders, crc);
+        crc = crc32c(levels_, sizeof(LevelNode) * hdr_->used_levels, crc);
+        return crc32c(slots_, sizeof(Slot) * (std::size_t{hdr_->slot_mask} + 1), crc);
+    }
+
+    void seal() {
+        if (hdr_->begin_seq != hdr_->applied_seq || hdr_->sealed) return;
+        hdr_->sealed_crc = image_crc();
+        std::atomic_signal_fence(std::memory_order_release);
+        hdr_->sealed = 1;
+    }
+
+    void commit(SeqNo seq) {
+        std::atomic_signal_fence(std::memory_order_release);
+        hdr_->applied_seq = seq;
+    }
+
+    // Restores every logged store, newest first. Idempotent, so a crash
+    // half-way through is repaired by the next open.
+    void rollback() {
+        for (std::uint32_t i = hdr_->undo_count; i-- > 0;) {
+            const UndoEntry &u = undo_[i];
+            std::memcpy(base_ + u.offset, &u.old, u.size);
+        }
+        std::atomic_signal_fence(std::memory_order_release);
+        hdr_->undo_count = 0;
+        std::atomic_signal_fence(std::memory_order_release);
+        hdr_->begin_seq = hdr_->applied_seq;
+    }
+
+    [[noreturn]] void fail(const char *what) {
+        rollback();
+        throw std::length_error(what);
+    }
+
+    // --- Matching (mirrors OrderBook::add_order) ---
+    std::vector<Trade> apply_new(const Order &in, SeqNo seq) {
+        begin(seq);
+        std::vector<Trade> trades;
+        Qty qty = in.qty;
+        int opp = in.side == Side::Buy ? 1 : 0;
+        while (qty > 0 && hdr_->best[opp] != kNil) {
+            std::uint32_t li = hdr_->best[opp];
+            LevelNode &lvl = levels_[li];
+            if (in.side == Side::Buy ? in.price < lvl.price : in.price > lvl.price) break;
+            while (qty > 0 && lvl.head != kNil) {
+                std::uint32_t oi = lvl.head;
+                OrderNode &resting = orders_[oi];
+                Qty traded = std::min(qty, resting.qty);
+                trades.push_back({resting.id, in.id, resting.price, traded});
+                qty -= traded;
+                set(resting.qty, resting.qty - traded);
+                if (resting.qty == 0) {
+                    index_erase(resting.id);
+                    unlink_order(oi);
+                } else {
+                    break; // partial on resting; remains in front
+                }
+            }
+            if (lvl.head == kNil) remove_level(opp, li);
+        }
+        if (qty > 0) enqueue(in, qty);
+        commit(seq);
+        return trades;
+    }
+
+    bool apply_cancel(OrderId id, SeqNo seq) {
+        begin(seq);
+        std::uint32_t si = index_find(id);
+        bool found = si != kNil;
+        if (found) {
+            std::uint32_t oi = slots_[si].node;
+            std::uint32_t li = orders_[oi].level;
+            int side = orders_[oi].side;
+            index_erase(id);
+            unlink_order(oi);
+            if (levels_[li].head == kNil) remove_level(side, li);
+        }
+        commit(seq);
+        return found;
+    }
+
+    void enqueue(const Order &o, Qty qty) {
+        int side = o.side == Side::Buy ? 0 : 1;
+        auto better = [&](Price a, Price b){ return side == 0 ? a > b : a < b; };
+        std::uint32_t prev = kNil, li = hdr_->best[side];
+        while (li != kNil && better(levels_[li].price, o.price)) {
+            prev = li;
+            li = levels_[li].worse;
+        }
+        if (li == kNil || levels_[li].price != o.price) {
+            std::uint32_t ni = alloc_level();
+            LevelNode &n = levels_[ni];
+            set(n.price, o.price);
+            set(n.head, kNil);
+            set(n.tail, kNil);
+            set(n.better, prev);
+            set(n.worse, li);
+            if (li != kNil) set(levels_[li].better, ni);
+            if (prev != kNil) set(levels_[prev].worse, ni);
+            else set(hdr_->best[side], ni);
+            li = ni;
+        }
+        std::uint32_t oi = alloc_order();
+        OrderNode &n = orders_[oi];
+        set(n.id, o.id);
+        set(n.price, o.price);
+        set(n.qty, qty);
+        set(n.ts, static_cast<std::int64_t>(o.ts.time_since_epoch().count()));
+        set(n.side, static_cast<std::uint8_t>(side));
+        set(n.level, li);
+        set(n.next, kNil);
+        LevelNode &lvl = levels_[li];
+        set(n.prev, lvl.tail);
+        if (lvl.tail != kNil) set(orders_[lvl.tail].next, oi);
+        else set(lvl.head, oi);
+        set(lvl.tail, oi);
+        index_insert(o.id, oi);
+    }
+
+    void unlink_order(std::uint32_t oi) {
+        OrderNode &n = orders_[oi];
+        LevelNode &lvl = levels_[n.level];
+        if (n.prev != kNil) set(orders_[n.prev].next, n.next);
+        else set(lvl.head, n.next);
+        if (n.next != kNil) set(orders_[n.next].prev, n.prev);
+        else set(lvl.tail, n.prev);
+        set(n.next, hdr_->free_order);
+        set(hdr_->free_order, oi);
+    }
+
+    void remove_level(int side, std::uint32_t li) {
+        LevelNode &lvl = levels_[li];
+        if (lvl.better != kNil) set(levels_[lvl.better].worse, lvl.worse);
+        else set(hdr_->best[side], lvl.worse);
+        if (lvl.worse != kNil) set(levels_[lvl.worse].better, lvl.better);
+        set(lvl.worse, hdr_->free_level);
+        set(hdr_->free_level, li);
+    }
+
+    std::uint32_t alloc_order() {
+        if (hdr_->free_order != kNil) {
+            std::uint32_t oi = hdr_->free_order;
+            set(hdr_->free_order, orders_[oi].next);
+            return oi;
+        }
+        if (hdr_->used_orders == hdr_->max_orders) fail("book: order pool exhausted");
+        set(hdr_->used_orders, hdr_->used_orders + 1);
+        return hdr_->used_orders - 1;
+    }
+
+    std::uint32_t alloc_level() {
+        if (hdr_->free_level != kNil) {
+            std::uint32_t li = hdr_->free_level;
+            set(hdr_->free_level, levels_[li].worse);
+            return li;
+        }
+        if (hdr_->used_levels == hdr_->max_levels) fail("book: level pool exhausted");
+        set(hdr_->used_levels, hdr_->used_levels + 1);
+        return hdr_->used_levels - 1;
+    }
+
+    // --- Id index: linear probing with backward-shift deletion ---
+    std::uint32_t home(OrderId id) const {
+        std::uint64_t h = id * 0x9E3779B97F4A7C15ull;
+        return static_cast<std::uint32_t>(h >> 32) & hdr_->slot_mask;
+    }
+
+    std::uint32_t index_find(OrderId id) const {
+        for (std::uint32_t i = home(id);; i = (i + 1) & hdr_->slot_mask) {
+            if (!slots_[i].used) return kNil;
+            if (slots_[i].id == id) return i;
+        }
+    }
+
+    void index_insert(OrderId id, std::uint32_t node) {
+        std::uint32_t i = home(id);
+        while (slots_[i].used) i = (i + 1) & hdr_->slot_mask;
+        set(slots_[i].id, id);
+        set(slots_[i].node, node);
+        set(slots_[i].used, 1u);
+    }
+
+    void index_erase(OrderId id) {
+        std::uint32_t mask = hdr_->slot_mask;
+        std::uint32_t i = index_find(id);
+        for (std::uint32_t j = (i + 1) & mask; slots_[j].used; j = (j + 1) & mask) {
+            std::uint32_t k = home(slots_[j].id);
+            bool stays = i <= j ? (i < k && k <= j) : (i < k || k <= j);
+            if (stays) continue;
+            set(slots_[i].id, slots_[j].id);
+            set(slots_[i].node, slots_[j].node);
+            i = j;
+        }
+        set(slots_[i].used, 0u);
+    }
+
+    std::optional<Price> best(Side s) const {
+        std::uint32_t li = hdr_->best[static_cast<int>(s)];
+        if (li == kNil) return std::nullopt;
+        return levels_[li].price;
+    }
+
+    void print_side(std::ostream &os, Side s) const {
+        for (std::uint32_t li = hdr_->best[static_cast<int>(s)]; li != kNil; li = levels_[li].worse) {
+            os << "  " << levels_[li].price << " : ";
+            for (std::uint32_t oi = levels_[li].head; oi != kNil; oi = orders_[oi].next)
+                os << orders_[oi].id << "x" << orders_[oi].qty << " ";
+            os << "\n";
+        }
+    }
+
+    int fd_ = -1;
+    std::size_t size_ = 0;
+    char *base_ = nullptr;
+    Header *hdr_ = nullptr;
+    OrderNode *orders_ = nullptr;
+    LevelNode *levels_ = nullptr;
+    Slot *slots_ = nullptr;
+    UndoEntry *undo_ = nullptr;
+    bool recovered_partial_ = false;
+    bool verified_ = false;
+};
@@ -0,0 +1,134 @@
+//
+//  Replayer.h
+//  XChange
+//
+//  Created by Williams on 17/10/2026.
+//
+#pragma once
+#include "Backtest.h"
+#include "SpscRing.h"
+
+#include <algorithm>
+
+// --- Parallel journal replay, partitioned by instrument ---
+//
+// Books are independent per instrument, so one reader thread walks the
+// mapped journal and hands each record (by pointer, 8 bytes) to the worker
+// owning its instrument over an SPSC ring. Every instrument is applied by
+// exactly one worker in journal order, so its trade stream is the same
+// whatever the worker count; only throughput changes.
+//
+// A verifier thread checks record checksums a chunk at a time ahead of the
+// reader, which only hands out records already verified. Checking runs in
+// parallel with decoding and no corrupt record ever reaches a book.
+
+struct InstrumentReplayResult {
+    InstrumentId  instrument{};
+    std::uint64_t commands{};
+    std::uint64_t trades{};
+    std::uint64_t trade_hash{0xcbf29ce484222325ull}; // FNV-1a over the trade stream
+};
+
+class ParallelReplayer {
+public:
+    // Called on the owning worker, in order for each instrument.
+    using TradeSink = std::function<void(InstrumentId, const Trade &)>;
+
+    explicit ParallelReplayer(unsigned workers, std::size_t ring_capacity = 1u << 14, TradeSink on_trade = {})
+        : workers_(std::max(1u, workers)), ring_capacity_(ring_capacity), on_trade_(std::move(on_trade)) {}
+
+    // Replays one journal (e.g. one day); results sorted by instrument.
+    std::vector<InstrumentReplayResult> replay(const std::string &path) const {
+        MappedJournal journal(path);
+        std::vector<std::unique_ptr<SpscRing<const Command *>>> rings;
+        std::vector<std::vector<InstrumentReplayResult>> partial(workers_);
+        for (unsigned w = 0; w < workers_; ++w)
+            rings.push_back(std::make_unique<SpscRing<const Command *>>(ring_capacity_));
+
+        std::vector<std::thread> threads;
+        for (unsigned w = 0; w < workers_; ++w)
+            threads.emplace_back([&, w]{ partial[w] = work(*rings[w]); });
+
+        const Command *records = journal.begin();
+        std::size_t total = journal.size();
+        std::atomic<std::size_t> verified{0};
+        std::atomic<bool> stopped{false};
+        bool corrupt = false;
+        std::thread verifier([&] {
+            constexpr std::size_t kChunk = 1024;
+            std::size_t i = 0;
+            while (i < total) {
+                std::size_t end = std::min(total, i + kChunk);
+                for (; i < end; ++i) {
+                    if (records[i].seq == 0) break; // zero padding left by a crash
+                    if (!journal_record_ok(records[i])) {
+                        corrupt = true;
+                        break;
+                    }
+                }
+                verified.store(i, std::memory_order_release);
+                if (i < end) break;
+            }
+            stopped.store(true, std::memory_order_release);
+        });
+
+        for (std::size_t i = 0;;) {
+            std::size_t ok = verified.load(std::memory_order_acquire);
+            if (i == ok) {
+                if (stopped.load(std::memory_order_acquire) && i == verified.load(std::memory_order_acquire)) break;
+                std::this_thread::yield();
+                continue;
+            }
+            for (; i < ok; ++i) rings[records[i].instrument % workers_]->push(&records[i]);
+        }
+        verifier.join();
+        for (auto &r : rings) r->push(nullptr); // end of stream
+        for (auto &t : threads) t.join();
+        if (corrupt)
+            throw std::runtime_error("replayer: checksum mismatch at record " + std::to_string(verified.load())
+                                     + " of " + path);
+
+        std::vector<InstrumentReplayResult> out;
+        for (auto &p : partial) out.insert(out.end(), p.begin(), p.end());
+        std::sort(out.begin(), out.end(), [](auto const &a, auto const &b){ return a.instrument < b.instrument; });
+        return out;
+    }
+
+private:
+    struct Instrument {
+        OrderBook book;
+        InstrumentReplayResult result;
+    };
+
+    std::vector<InstrumentReplayResult> work(SpscRing<const Command *> &ring) const {
+        std::unordered_map<InstrumentId, Instrument> books;
+        std::vector<Trade> trades;
+        Instrument *cur = nullptr;
+        InstrumentId cur_id{};
+        for (const Command *c; (c = ring.pop()) != nullptr;) {
+            if (!cur || c->instrument != cur_id) { // runs of one instrument skip the lookup
+                cur_id = c->instrument;
+                cur = &books[cur_id];
+                cur->result.instrument = cur_id;
+            }
+            ++cur->result.commands;
+            trades.clear();
+            cur->book.apply(*c, trades);
+            cur->result.trades += trades.size();
+            for (auto const &t : trades) {
+                for (std::uint64_t v : {t.maker_id, t.taker_id, static_cast<std::uint64_t>(t.price),
+                                        static_cast<std::uint64_t>(t.qty)})
+                    cur->result.trade_hash = (cur->result.trade_hash ^ v) * 0x100000001b3ull;
+                if (on_trade_) on_trade_(cur_id, t);
+            }
+        }
+        std::vector<InstrumentReplayResult> out;
+        out.reserve(books.size());
+        for (auto const &[id, inst] : books) out.push_back(inst.result);
+        return out;
+    }
+
+    unsigned workers_;
+    std::size_t ring_capacity_;
+    TradeSink on_trade_;
+};
@@ -0,0 +1,230 @@
+//
+//  Replication.h
+//  XChange
+//
+//  Created by Williams on 17/10/2026.
+//
+#pragma once
+#include "AsyncOrderBook.h"
+
+#include <cstring>
+#include <sys/socket.h>
+#include <unistd.h>
+
+// --- Primary/backup replication over a local stream socket ---
+//
+// The primary forwards every sequenced Command to the standby, which applies
+// it to its own OrderBook in the same order. Both sides are deterministic, so
+// their trade output is identical. Acks flow back as the highest seq the
+// standby has received/applied; the primary only waits for them as far as
+// ReplicationConfig asks.
+
+enum class AckMode : std::uint8_t {
+    None     = 0, // fire and forget; standby never acks
+    Received = 1, // standby acks once the record is read off the socket
+    Applied  = 2, // standby acks once the record is applied to its book
+};
+
+struct ReplicationConfig {
+    AckMode ack{AckMode::Applied};
+    // Commands allowed in flight before the matcher blocks on an ack.
+    // 0 = fully synchronous (every command waits for its own ack).
+    SeqNo   max_in_flight{1024};
+};
+
+namespace replication_detail {
+
+inline bool write_all(int fd, const void *buf, std::size_t n) {
+    auto p = static_cast<const char *>(buf);
+    while (n > 0) {
+#ifdef MSG_NOSIGNAL
+        ssize_t w = ::send(fd, p, n, MSG_NOSIGNAL);
+#else
+        ssize_t w = ::write(fd, p, n);
+#endif
+        if (w <= 0) return false;
+        p += w;
+        n -= static_cast<std::size_t>(w);
+    }
+    return true;
+}
+
+inline bool read_all(int fd, void *buf, std::size_t n) {
+    auto p = static_cast<char *>(buf);
+    while (n > 0) {
+        ssize_t r = ::read(fd, p, n);
+        if (r <= 0) return false; // EOF or error
+        p += r;
+        n -= static_cast<std::size_t>(r);
+    }
+    return true;
+}
+
+} // namespace replication_detail
+
+// --- Primary side: pass on_sequenced() as the engine's SequencedSink ---
+class ReplicationPrimary {
+public:
+    ReplicationPrimary(int fd, ReplicationConfig cfg = {})
+        : fd_(fd), cfg_(cfg),
+          sender_([this]{ send_loop(); }),
+          acker_([this]{ ack_loop(); }) {}
+
+    ~ReplicationPrimary() { close(); }
+
+    // Matching thread: hand the record to the sender, then block only if the
+    // configured ack window is exhausted.
+    void on_sequenced(const Command &c) {
+        outq_.push(c);
+        if (cfg_.ack == AckMode::None) return;
+        if (c.seq > cfg_.max_in_flight) wait_acked(c.seq - cfg_.max_in_flight);
+    }
+
+    AsyncMatchingEngine::SequencedSink sink() {
+        return [this](const Command &c){ on_sequenced(c); };
+    }
+
+    // Blocks until the standby acked `seq` (or the link went down).
+    bool wait_acked(SeqNo seq) {
+        std::unique_lock<std::mutex> lk(m_);
+        cv_.wait(lk, [&]{ return link_down_ || acked_.load(std::memory_order_acquire) >= seq; });
+        return acked_.load(std::memory_order_acquire) >= seq;
+    }
+
+    SeqNo acked_seq() const { return acked_.load(std::memory_order_acquire); }
+
+    // Flushes pending records and half-closes the socket; the standby sees
+    // EOF after the last record.
+    void close() {
+        if (closed_.exchange(true)) return;
+        outq_.close();
+        if (sender_.joinable()) sender_.join();
+        ::shutdown(fd_, SHUT_WR);
+        if (acker_.joinable()) acker_.join();
+        ::close(fd_);
+    }
+
+private:
+    void send_loop() {
+        std::vector<Command> batch;
+        Command c;
+        while (outq_.pop(c)) {
+            // Coalesce whatever is already queued into one write.
+            batch.clear();
+            batch.push_back(c);
+            while (batch.size() < 256 && outq_.try_pop(c)) batch.push_back(c);
+            if (!replication_detail::write_all(fd_, batch.data(), batch.size() * sizeof(Command))) {
+                mark_down();
+                return;
+            }
+        }
+    }
+
+    void ack_loop() {
+        SeqNo seq;
+        while (replication_detail::read_all(fd_, &seq, sizeof(seq))) {
+            {
+                std::lock_guard<std::mutex> lk(m_);
+                acked_.store(seq, std::memory_order_release);
+            }
+            cv_.notify_all();
+        }
+        mark_down();
+    }
+
+    void mark_down() {
+        {
+            std::lock_guard<std::mutex> lk(m_);
+            link_down_ = true;
+        }
+        cv_.notify_all();
+    }
+
+    int fd_;
+    ReplicationConfig cfg_;
+    ConcurrentQueue<Command> outq_{};
+    std::mutex m_;
+    std::condition_variable cv_;
+    std::atomic<SeqNo> acked_{0};
+    bool link_down_ = false;
+    std::atomic<bool> closed_{false};
+    std::thread sender_;
+    std::thread acker_;
+};
+
+// --- Standby side: applies the primary's stream to its own book in lockstep ---
+class ReplicationStandby {
+public:
+    using TradeSink = std::function<void(const Trade &)>;
+
+    ReplicationStandby(int fd, AckMode ack, TradeSink on_trade = {})
+        : fd_(fd), ack_(ack), on_trade_(std::move(on_trade)), worker_([this]{ run(); }) {}
+
+    ~ReplicationStandby() { join(); }
+
+    // Returns once the primary closed the stream (or it broke).
+    void join() {
+        if (worker_.joinable()) worker_.join();
+    }
+
+    SeqNo applied_seq() const { return applied_.load(std::memory_order_acquire); }
+    // True if the stream had a sequence gap or a torn record.
+    bool failed() const { return failed_.load(std::memory_order_acquire); }
+
+    // Only safe once join() returned.
+    const OrderBook &book() const { return book_; }
+
+private:
+    void run() {
+        constexpr std::size_t kBatch = 256;
+        std::vector<Command> buf(kBatch);
+        std::size_t have = 0; // bytes buffered
+        auto bytes = reinterpret_cast<char *>(buf.data());
+        for (;;) {
+            ssize_t r = ::read(fd_, bytes + have, kBatch * sizeof(Command) - have);
+            if (r <= 0) {
+                if (have != 0) failed_.store(true, std::memory_order_release);
+                break;
+            }
+            have += static_cast<std::size_t>(r);
+            std::size_t n = have / sizeof(Command);
+            if (n == 0) continue;
+            if (ack_ == AckMode::Received) send_ack(buf[n - 1].seq);
+            for (std::size_t i = 0; i < n; ++i) {
+                if (!apply(buf[i])) {
+                    failed_.store(true, std::memory_order_release);
+                    ::close(fd_);
+                    return;
+                }
+            }
+            if (ack_ == AckMode::Applied) send_ack(buf[n - 1].seq);
+            // Keep any trailing partial record for the next read.
+            std::size_t used = n * sizeof(Command);
+            std::memmove(bytes, bytes + used, have - used);
+            have -= used;
+        }
+        ::close(fd_);
+    }
+
+    bool apply(Command c) {
+        if (c.seq != applied_.load(std::memory_order_relaxed) + 1) return false; // gap
+        trades_.clear();
+        book_.apply(c, trades_);
+        if (on_trade_) for (auto const &t : trades_) on_trade_(t);
+        applied_.store(c.seq, std::memory_order_release);
+        return true;
+    }
+
+    void send_ack(SeqNo seq) {
+        replication_detail::write_all(fd_, &seq, sizeof(seq));
+    }
+
+    int fd_;
+    AckMode ack_;
+    TradeSink on_trade_;
+    OrderBook book_{};
+    std::vector<Trade> trades_; // reused per command
+    std::atomic<SeqNo> applied_{0};
+    std::atomic<bool> failed_{false};
+    std::thread worker_;
+};
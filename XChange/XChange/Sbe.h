@@ -0,0 +1,234 @@
+//
+//  Sbe.h
+//  XChange
+//
+//  Created by Williams on 17/10/2026.
+//
+#pragma once
+#include "AsyncOrderBook.h"
+
+#include <bit>
+#include <cstring>
+#include <tuple>
+
+// --- Outbound wire format: SBE-style fixed-offset messages ---
+//
+// Each message is an 8-byte SbeHeader (block length, template id, schema id,
+// version) followed by a block of little-endian fields, packed in schema
+// order at offsets computed at compile time. A schema is a struct listing
+// its fields' types; SbeFlyweight reads and writes them in place, so
+// encoding is a header store plus one store per field, straight into the
+// caller's egress buffer, and a reader in another process decodes by
+// loading from the same offsets. Fields are only ever appended (with a
+// version bump); readers step by the header's block length, so an old
+// reader skips fields it does not know.
+
+static_assert(std::endian::native == std::endian::little, "sbe: fields are stored in native order");
+
+struct SbeHeader {
+    std::uint16_t block_length{};
+    std::uint16_t template_id{};
+    std::uint16_t schema_id{};
+    std::uint16_t version{};
+};
+
+static_assert(sizeof(SbeHeader) == 8);
+
+inline constexpr std::uint16_t kSbeSchemaId = 0x5843; // "XC"
+inline constexpr std::uint16_t kSbeSchemaVersion = 1;
+
+// --- Schema (append-only) ---
+
+struct TradeMessage {
+    static constexpr std::uint16_t kTemplateId = 1;
+    enum Field { kInstrument, kMaker, kTaker, kPrice, kQty };
+    using Types = std::tuple<InstrumentId, OrderId, OrderId, Price, Qty>;
+};
+
+// One changed depth level; qty 0 means the level is gone.
+struct BookDeltaMessage {
+    static constexpr std::uint16_t kTemplateId = 2;
+    enum Field { kSeq, kInstrument, kSide, kPrice, kQty, kOrders };
+    using Types = std::tuple<SeqNo, InstrumentId, std::uint8_t, Price, Qty, std::uint32_t>;
+};
+
+struct AckMessage {
+    static constexpr std::uint16_t kTemplateId = 3;
+    enum Field { kRequest, kOrder, kSeq, kStatus, kReason, kFilled, kLeaves };
+    using Types = std::tuple<RequestId, OrderId, SeqNo, std::uint8_t, std::uint8_t, Qty, Qty>;
+};
+
+namespace sbe_detail {
+
+template <typename Types, std::size_t I>
+constexpr std::size_t offset() {
+    if constexpr (I == 0) return 0;
+    else return offset<Types, I - 1>() + sizeof(std::tuple_element_t<I - 1, Types>);
+}
+
+} // namespace sbe_detail
+
+// View of one message block. Byte = const char for a read-only view.
+template <typename Schema, typename Byte = char>
+class SbeFlyweight {
+    using Types = typename Schema::Types;
+
+public:
+    static constexpr std::size_t kBlockLength = sbe_detail::offset<Types, std::tuple_size_v<Types>>();
+
+    explicit SbeFlyweight(Byte *block) : p_(block) {}
+
+    template <std::size_t F>
+    std::tuple_element_t<F, Types> get() const {
+        std::tuple_element_t<F, Types> v;
+        std::memcpy(&v, p_ + sbe_detail::offset<Types, F>(), sizeof(v));
+        return v;
+    }
+
+    template <std::size_t F>
+    SbeFlyweight &set(std::tuple_element_t<F, Types> v) requires(!std::is_const_v<Byte>) {
+        std::memcpy(p_ + sbe_detail::offset<Types, F>(), &v, sizeof(v));
+        return *this;
+    }
+
+private:
+    Byte *p_;
+};
+
+// Appends messages to a caller-owned buffer.
+class SbeWriter {
+public:
+    SbeWriter(char *buf, std::size_t capacity) : buf_(buf), cap_(capacity) {}
+
+    // Writes the header and returns the block to fill in; nullopt (nothing
+    // written) if the message does not fit.
+    template <typename Schema>
+    std::optional<SbeFlyweight<Schema>> append() {
+        constexpr std::size_t block = SbeFlyweight<Schema>::kBlockLength;
+        if (cap_ - len_ < sizeof(SbeHeader) + block) return std::nullopt;
+        SbeHeader h{static_cast<std::uint16_t>(block), Schema::kTemplateId, kSbeSchemaId, kSbeSchemaVersion};
+        std::memcpy(buf_ + len_, &h, sizeof(h));
+        SbeFlyweight<Schema> fw(buf_ + len_ + sizeof(h));
+        len_ += sizeof(h) + block;
+        return fw;
+    }
+
+    const char *data() const { return buf_; }
+    std::size_t size() const { return len_; }
+    std::size_t remaining() const { return cap_ - len_; }
+    void clear() { len_ = 0; }
+
+private:
+    char *buf_;
+    std::size_t cap_;
+    std::size_t len_ = 0;
+};
+
+// Calls f(header, block) for each whole message in [p, p + n), in place.
+// Returns the bytes consumed; a trailing partial message is left for the
+// next call.
+template <typename F>
+std::size_t sbe_for_each(const char *p, std::size_t n, F &&f) {
+    std::size_t off = 0;
+    while (n - off >= sizeof(SbeHeader)) {
+        SbeHeader h;
+        std::memcpy(&h, p + off, sizeof(h));
+        if (n - off - sizeof(h) < h.block_length) break;
+        f(static_cast<const SbeHeader &>(h), p + off + sizeof(h));
+        off += sizeof(h) + h.block_length;
+    }
+    return off;
+}
+
+// Read-only view of `block` if `h` is a message of this schema.
+template <typename Schema>
+std::optional<SbeFlyweight<Schema, const char>> sbe_view(const SbeHeader &h, const char *block) {
+    if (h.schema_id != kSbeSchemaId || h.template_id != Schema::kTemplateId
+        || h.block_length < SbeFlyweight<Schema>::kBlockLength)
+        return std::nullopt;
+    return SbeFlyweight<Schema, const char>(block);
+}
+
+// --- Encoders for the engine's output ---
+
+inline bool sbe_encode(SbeWriter &w, InstrumentId instrument, const Trade &t) {
+    auto m = w.append<TradeMessage>();
+    if (!m) return false;
+    m->set<TradeMessage::kInstrument>(instrument)
+        .set<TradeMessage::kMaker>(t.maker_id)
+        .set<TradeMessage::kTaker>(t.taker_id)
+        .set<TradeMessage::kPrice>(t.price)
+        .set<TradeMessage::kQty>(t.qty);
+    return true;
+}
+
+inline bool sbe_encode(SbeWriter &w, const Ack &a) {
+    auto m = w.append<AckMessage>();
+    if (!m) return false;
+    m->set<AckMessage::kRequest>(a.request)
+        .set<AckMessage::kOrder>(a.order)
+        .set<AckMessage::kSeq>(a.seq)
+        .set<AckMessage::kStatus>(static_cast<std::uint8_t>(a.status))
+        .set<AckMessage::kReason>(static_cast<std::uint8_t>(a.reason))
+        .set<AckMessage::kFilled>(a.filled)
+        .set<AckMessage::kLeaves>(a.leaves);
+    return true;
+}
+
+// Trades and acks of one event. Returns messages written; stops early if
+// the buffer fills.
+inline std::size_t sbe_encode(SbeWriter &w, InstrumentId instrument, const EngineEvent &ev) {
+    std::size_t n = 0;
+    for (auto const &t : ev.trades) {
+        if (!sbe_encode(w, instrument, t)) return n;
+        ++n;
+    }
+    for (auto const &a : ev.acks) {
+        if (!sbe_encode(w, a)) return n;
+        ++n;
+    }
+    return n;
+}
+
+// Book deltas taking `prev` (null = empty book) to `next`: one message per
+// level that appeared, changed or went away. Returns messages written;
+// stops early if the buffer fills.
+inline std::size_t sbe_encode_depth(SbeWriter &w, InstrumentId instrument, const DepthSnapshot *prev,
+                                    const DepthSnapshot &next) {
+    static const std::vector<DepthLevel> kNone;
+    std::size_t n = 0;
+    bool full = false;
+    auto emit = [&](Side side, Price px, Qty qty, std::uint32_t orders) {
+        auto m = w.append<BookDeltaMessage>();
+        if (!m) {
+            full = true;
+            return;
+        }
+        m->set<BookDeltaMessage::kSeq>(next.seq)
+            .set<BookDeltaMessage::kInstrument>(instrument)
+            .set<BookDeltaMessage::kSide>(static_cast<std::uint8_t>(side))
+            .set<BookDeltaMessage::kPrice>(px)
+            .set<BookDeltaMessage::kQty>(qty)
+            .set<BookDeltaMessage::kOrders>(orders);
+        ++n;
+    };
+    // Both sides are best first; `before(a, b)`: a sorts ahead of b.
+    auto diff = [&](Side side, const std::vector<DepthLevel> &a, const std::vector<DepthLevel> &b, auto before) {
+        std::size_t i = 0, j = 0;
+        while (!full && (i < a.size() || j < b.size())) {
+            if (j == b.size() || (i < a.size() && before(a[i].price, b[j].price))) {
+                emit(side, a[i++].price, 0, 0);
+            } else if (i == a.size() || before(b[j].price, a[i].price)) {
+                emit(side, b[j].price, b[j].qty, b[j].orders);
+                ++j;
+            } else {
+                if (a[i].qty != b[j].qty || a[i].orders != b[j].orders) emit(side, b[j].price, b[j].qty, b[j].orders);
+                ++i;
+                ++j;
+            }
+        }
+    };
+    diff(Side::Buy, prev ? prev->bids : kNone, next.bids, std::greater<Price>{});
+    diff(Side::Sell, prev ? prev->asks : kNone, next.asks, std::less<Price>{});
+    return n;
+}
@@ -0,0 +1,190 @@
+//
+//  Spreads.h
+//  XChange
+//
+//  Created by Williams on 17/10/2026.
+//
+#pragma once
+#include "OrderBook.h"
+
+// --- Calendar spreads: implied-in / implied-out matching on one shard ---
+//
+// A shard owns three books: near (A), far (B) and the spread S = A - B
+// (buying S buys A and sells B). Each outright or spread top of book, taken
+// together with one other, implies a quote in the third book:
+//
+//   A ask = S ask + B ask     A bid = S bid + B bid      (implied out)
+//   B ask = A ask - S bid     B bid = A bid - S ask      (implied out)
+//   S ask = A ask - B bid     S bid = A bid - B ask      (implied in)
+//
+// Only first-generation implieds from direct quotes are built. The shard
+// caches each book's best levels; when one changes, only the two implied
+// quotes that read it are recomputed. An incoming order takes the better
+// of the direct and implied price at each step (direct first on a tie). An
+// implied fill hits both source levels for the same qty, sized up front
+// from their cached totals, so on this single-threaded shard both legs
+// always complete together.
+
+struct LegFill {
+    InstrumentId instrument{};
+    Trade        trade{};
+    bool         implied{}; // part of an implied execution (a source leg, or the taker's synthetic fill)
+};
+
+class CalendarSpreadShard {
+public:
+    struct Quote {
+        Price price{};
+        Qty   qty{};   // 0 = no quote
+        bool operator==(const Quote &) const = default;
+    };
+
+    CalendarSpreadShard(InstrumentId near, InstrumentId far, InstrumentId spread)
+        : ids_{near, far, spread} {}
+
+    bool owns(InstrumentId id) const { return leg_of(id) >= 0; }
+
+    // Matches `o` on `instrument` against direct and implied liquidity, then
+    // rests any remainder in that book. Fills are appended to `fills`.
+    void add_order(InstrumentId instrument, Order o, std::vector<LegFill> &fills) {
+        int t = leg_index(instrument);
+        bool buy = o.side == Side::Buy;
+        int opp = buy ? kAsk : kBid;
+        while (o.qty > 0) {
+            const Quote &direct = bbo_[t][opp];
+            const Quote &implied = implied_[t][opp];
+            bool use_direct = direct.qty > 0
+                && (implied.qty == 0 || (buy ? direct.price <= implied.price : direct.price >= implied.price));
+            const Quote &q = use_direct ? direct : implied;
+            if (q.qty == 0 || (buy ? o.price < q.price : o.price > q.price)) break; // nothing crossable
+            Qty take = std::min(o.qty, q.qty);
+            if (use_direct) {
+                hit(t, opp, o.id, q.price, take, false, fills);
+                refresh(t);
+            } else {
+                Price px = q.price;
+                const Source &s = kSources[t][opp];
+                Price p0 = bbo_[s.a.leg][s.a.side].price, p1 = bbo_[s.b.leg][s.b.side].price;
+                hit(s.a.leg, s.a.side, o.id, p0, take, true, fills);
+                hit(s.b.leg, s.b.side, o.id, p1, take, true, fills);
+                fills.push_back({ids_[t], Trade{0, o.id, px, take}, true});
+                ++implied_fills_;
+                refresh(s.a.leg);
+                refresh(s.b.leg);
+            }
+            o.qty -= take;
+        }
+        if (o.qty > 0) {
+            scratch_.clear();
+            books_[t].add_order(o, scratch_); // not crossable any more: rests
+            refresh(t);
+        }
+    }
+
+    bool cancel(InstrumentId instrument, OrderId id) {
+        int t = leg_index(instrument);
+        if (!books_[t].cancel(id)) return false;
+        refresh(t);
+        return true;
+    }
+
+    Quote best(InstrumentId instrument, Side side) const { return bbo_[leg_index(instrument)][side_index(side)]; }
+    Quote implied(InstrumentId instrument, Side side) const { return implied_[leg_index(instrument)][side_index(side)]; }
+    const OrderBook &book(InstrumentId instrument) const { return books_[leg_index(instrument)]; }
+
+    // Implied quotes recomputed so far (each is O(1)), and implied executions.
+    std::uint64_t implied_updates() const { return implied_updates_; }
+    std::uint64_t implied_fills() const { return implied_fills_; }
+
+    // Implied quote for (leg, side) built from scratch; for checking the cache.
+    Quote implied_from_scratch(InstrumentId instrument, Side side) const {
+        int t = leg_index(instrument), sd = side_index(side);
+        std::pair<Price, Qty> a = level(kSources[t][sd].a), b = level(kSources[t][sd].b);
+        return combine(t, Quote{a.first, a.second}, Quote{b.first, b.second});
+    }
+
+private:
+    static constexpr int kNear = 0, kFar = 1, kSpread = 2;
+    static constexpr int kBid = 0, kAsk = 1;
+
+    struct Ref {
+        int leg, side;
+    };
+    // The two top-of-book quotes an implied (leg, side) is built from.
+    struct Source {
+        Ref a, b;
+    };
+    static constexpr Source kSources[3][2] = {
+        /* A */ {{{kSpread, kBid}, {kFar, kBid}},  {{kSpread, kAsk}, {kFar, kAsk}}},
+        /* B */ {{{kNear, kBid}, {kSpread, kAsk}}, {{kNear, kAsk}, {kSpread, kBid}}},
+        /* S */ {{{kNear, kBid}, {kFar, kAsk}},    {{kNear, kAsk}, {kFar, kBid}}},
+    };
+
+    // The two implied quotes each top-of-book quote feeds (inverse of kSources).
+    static constexpr Ref kDependents[3][2][2] = {
+        /* A */ {{{kFar, kBid}, {kSpread, kBid}},  {{kFar, kAsk}, {kSpread, kAsk}}},
+        /* B */ {{{kNear, kBid}, {kSpread, kAsk}}, {{kNear, kAsk}, {kSpread, kBid}}},
+        /* S */ {{{kNear, kBid}, {kFar, kAsk}},    {{kNear, kAsk}, {kFar, kBid}}},
+    };
+
+    static int side_index(Side s) { return s == Side::Buy ? kBid : kAsk; }
+
+    int leg_of(InstrumentId id) const {
+        for (int i = 0; i < 3; ++i)
+            if (ids_[i] == id) return i;
+        return -1;
+    }
+
+    int leg_index(InstrumentId id) const {
+        int i = leg_of(id);
+        if (i < 0) throw std::out_of_range("spread shard: instrument " + std::to_string(id) + " not on this shard");
+        return i;
+    }
+
+    // A is S + B; B and S are differences of the first source and the second.
+    static Quote combine(int leg, Quote a, Quote b) {
+        if (a.qty == 0 || b.qty == 0) return {};
+        return {leg == kNear ? a.price + b.price : a.price - b.price, std::min(a.qty, b.qty)};
+    }
+
+    std::pair<Price, Qty> level(Ref r) const {
+        const OrderBook &b = books_[r.leg];
+        auto px = r.side == kBid ? b.best_bid() : b.best_ask();
+        if (!px) return {0, 0};
+        Qty q = 0;
+        b.for_each_at_level(r.side == kBid ? Side::Buy : Side::Sell, *px, [&](OrderId, Qty x) { q += x; });
+        return {*px, q};
+    }
+
+    // Takes `qty` (no more than the level holds) at the best `side` level of
+    // `leg`: the taker crosses that one level exactly and never rests.
+    void hit(int leg, int side, OrderId taker, Price px, Qty qty, bool implied, std::vector<LegFill> &fills) {
+        scratch_.clear();
+        books_[leg].add_order(Order{taker, side == kAsk ? Side::Buy : Side::Sell, px, qty, {}}, scratch_);
+        for (auto const &t : scratch_) fills.push_back({ids_[leg], t, implied});
+    }
+
+    // Re-reads both best levels of `leg`; if one moved, recomputes the two
+    // implied quotes that read it.
+    void refresh(int leg) {
+        for (int side = kBid; side <= kAsk; ++side) {
+            auto [px, q] = level(Ref{leg, side});
+            Quote now{px, q};
+            if (now == bbo_[leg][side]) continue;
+            bbo_[leg][side] = now;
+            for (const Ref &d : kDependents[leg][side]) {
+                const Source &s = kSources[d.leg][d.side];
+                implied_[d.leg][d.side] = combine(d.leg, bbo_[s.a.leg][s.a.side], bbo_[s.b.leg][s.b.side]);
+                ++implied_updates_;
+            }
+        }
+    }
+
+    InstrumentId ids_[3];
+    OrderBook books_[3];
+    Quote bbo_[3][2]{};     // direct best level per leg and side
+    Quote implied_[3][2]{}; // implied quote per leg and side
+    std::vector<Trade> scratch_;
+    std::uint64_t implied_updates_ = 0;
+    std::uint64_t implied_fills_ = 0;
+};
@@ -0,0 +1,75 @@
+//
+//  SpscRing.h
+//  XChange
+//
+//  Created by Williams on 17/10/2026.
+//
+#pragma once
+#include "Types.h"
+
+#include <memory>
+
+// --- Bounded lock-free single-producer/single-consumer ring ---
+//
+// Head and tail live on their own cache lines and each side keeps a cached
+// copy of the other's index, so the shared lines are only touched when the
+// cached view says full/empty.
+template <typename T>
+class SpscRing {
+public:
+    // Capacity is rounded up to a power of two.
+    explicit SpscRing(std::size_t capacity = 1u << 16) {
+        std::size_t cap = 2;
+        while (cap < capacity) cap <<= 1;
+        mask_ = cap - 1;
+        buf_ = std::make_unique<T[]>(cap);
+    }
+    SpscRing(const SpscRing &) = delete;
+    SpscRing &operator=(const SpscRing &) = delete;
+
+    // Producer only. False if full.
+    bool try_push(const T &v) {
+        std::size_t t = tail_.load(std::memory_order_relaxed);
+        if (t - head_cache_ > mask_) {
+            head_cache_ = head_.load(std::memory_order_acquire);
+            if (t - head_cache_ > mask_) return false;
+        }
+        buf_[t & mask_] = v;
+        tail_.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Producer only. Spins (yielding) while full.
+    void push(const T &v) {
+        while (!try_push(v)) std::this_thread::yield();
+    }
+
+    // Consumer only. False if empty.
+    bool try_pop(T &out) {
+        std::size_t h = head_.load(std::memory_order_relaxed);
+        if (h == tail_cache_) {
+            tail_cache_ = tail_.load(std::memory_order_acquire);
+            if (h == tail_cache_) return false;
+        }
+        out = buf_[h & mask_];
+        head_.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer only. Spins (yielding) while empty.
+    T pop() {
+        T v;
+        while (!try_pop(v)) std::this_thread::yield();
+        return v;
+    }
+
+    std::size_t capacity() const { return mask_ + 1; }
+
+private:
+    alignas(64) std::atomic<std::size_t> head_{0}; // consumer writes
+    std::size_t tail_cache_ = 0;                   // consumer's view of tail_
+    alignas(64) std::atomic<std::size_t> tail_{0}; // producer writes
+    std::size_t head_cache_ = 0;                   // producer's view of head_
+    alignas(64) std::size_t mask_ = 0;
+    std::unique_ptr<T[]> buf_;
+};
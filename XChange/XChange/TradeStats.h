@@ -0,0 +1,162 @@
+//
+//  TradeStats.h
+//  XChange
+//
+//  Created by Williams on 17/10/2026.
+//
+#pragma once
+#include "Types.h"
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
+
+// --- Incremental per-instrument trade statistics ---
+//
+// Fed from the engine's trade output (per-maker trades or ExecutionSummary),
+// each update is O(1): running volume/notional for VWAP, and an OHLC bar
+// that rolls over when a trade lands in a later interval. After each update
+// the instrument's latest snapshot is published on a Conflated channel, so
+// readers always see the newest value and never slow the writer down.
+
+// Latest-value channel (seqlock). One writer; any number of readers, who
+// retry if they raced a publish. Intermediate values may be skipped.
+template <typename T>
+class Conflated {
+    static_assert(std::is_trivially_copyable_v<T>);
+
+public:
+    void publish(const T &v) {
+        std::uint64_t s = seq_.load(std::memory_order_relaxed);
+        seq_.store(s + 1, std::memory_order_relaxed); // odd: write in progress
+        std::atomic_thread_fence(std::memory_order_release);
+        std::memcpy(&value_, &v, sizeof(T));
+        seq_.store(s + 2, std::memory_order_release);
+    }
+
+    // False until the first publish.
+    bool read(T &out) const {
+        for (;;) {
+            std::uint64_t before = seq_.load(std::memory_order_acquire);
+            if (before == 0) return false;
+            if (before & 1) continue;
+            std::memcpy(&out, &value_, sizeof(T));
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (seq_.load(std::memory_order_relaxed) == before) return true;
+        }
+    }
+
+    // Publishes so far; lets a poller skip an unchanged value.
+    std::uint64_t version() const { return seq_.load(std::memory_order_acquire) / 2; }
+
+private:
+    alignas(64) std::atomic<std::uint64_t> seq_{0};
+    T value_{};
+};
+
+struct OhlcBar {
+    std::int64_t  start_ns{}; // interval start, ns on the caller's clock
+    Price         open{}, high{}, low{}, close{};
+    Qty           volume{};
+    std::uint64_t trades{};
+};
+
+struct TradeStatsSnapshot {
+    InstrumentId  instrument{};
+    std::uint64_t updates{};  // bumps on every publish
+    Price         last_price{};
+    Qty           volume{};   // since start
+    std::uint64_t trades{};
+    std::int64_t  notional{}; // sum of price * qty, in ticks
+    OhlcBar       bar{};      // interval in progress
+    OhlcBar       prev_bar{}; // last completed interval (start_ns 0 if none yet)
+
+    double vwap() const { return volume ? static_cast<double>(notional) / static_cast<double>(volume) : 0.0; }
+};
+
+class TradeStatistics {
+public:
+    // Instruments are dense ids in [0, max_instruments); all channels exist
+    // up front so readers can hold a pointer while the writer runs.
+    explicit TradeStatistics(std::size_t max_instruments,
+                             std::chrono::nanoseconds bar_interval = std::chrono::seconds(1))
+        : interval_ns_(std::max<std::int64_t>(1, bar_interval.count())),
+          slots_(std::make_unique<Slot[]>(max_instruments)), size_(max_instruments) {
+        for (std::size_t i = 0; i < size_; ++i) slots_[i].stats.instrument = static_cast<InstrumentId>(i);
+    }
+
+    // --- Writer side (one thread) ---
+
+    void on_trade(InstrumentId instrument, const Trade &t, std::int64_t ts_ns) {
+        Slot &s = slot(instrument);
+        add(s.stats, ts_ns, t.price, t.price, t.qty, 1, t.price * t.qty);
+        publish(s);
+    }
+
+    // One publish for the whole batch (e.g. an EngineEvent's trades).
+    void on_trades(InstrumentId instrument, const std::vector<Trade> &trades, std::int64_t ts_ns) {
+        if (trades.empty()) return;
+        Slot &s = slot(instrument);
+        for (auto const &t : trades) add(s.stats, ts_ns, t.price, t.price, t.qty, 1, t.price * t.qty);
+        publish(s);
+    }
+
+    // A sweep walks prices monotonically, so first/last price bound the
+    // fills and the bar needs no per-maker detail.
+    void on_execution(InstrumentId instrument, const ExecutionSummary &e, std::int64_t ts_ns) {
+        if (e.fills == 0) return;
+        Slot &s = slot(instrument);
+        add(s.stats, ts_ns, e.first_price, e.last_price, e.filled_qty, e.fills, e.notional);
+        publish(s);
+    }
+
+    // --- Reader side (any thread) ---
+
+    const Conflated<TradeStatsSnapshot> &channel(InstrumentId instrument) const { return slot(instrument).out; }
+
+    bool read(InstrumentId instrument, TradeStatsSnapshot &out) const { return channel(instrument).read(out); }
+
+    std::size_t instruments() const { return size_; }
+
+private:
+    struct Slot {
+        TradeStatsSnapshot stats;           // writer's working copy
+        Conflated<TradeStatsSnapshot> out;
+    };
+
+    Slot &slot(InstrumentId i) const {
+        if (i >= size_) throw std::out_of_range("trade stats: instrument " + std::to_string(i));
+        return slots_[i];
+    }
+
+    // Prices of the update run monotonically from `first` to `last`.
+    void add(TradeStatsSnapshot &st, std::int64_t ts_ns, Price first, Price last, Qty qty,
+             std::uint64_t fills, std::int64_t notional) const {
+        std::int64_t start = ts_ns - ((ts_ns % interval_ns_) + interval_ns_) % interval_ns_; // floor
+        OhlcBar &bar = st.bar;
+        if (bar.trades == 0 || start > bar.start_ns) {
+            if (bar.trades) st.prev_bar = bar;
+            bar = OhlcBar{start, first, first, first, first, 0, 0};
+        }
+        bar.high = std::max({bar.high, first, last});
+        bar.low = std::min({bar.low, first, last});
+        bar.close = last;
+        bar.volume += qty;
+        bar.trades += fills;
+        st.last_price = last;
+        st.volume += qty;
+        st.trades += fills;
+        st.notional += notional;
+    }
+
+    static void publish(Slot &s) {
+        ++s.stats.updates;
+        s.out.publish(s.stats);
+    }
+
+    std::int64_t interval_ns_;
+    std::unique_ptr<Slot[]> slots_;
+    std::size_t size_;
+};
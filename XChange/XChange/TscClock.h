@@ -0,0 +1,109 @@
+//
+//  TscClock.h
+//  XChange
+//
+//  Created by Williams on 17/10/2026.
+//
+#pragma once
+#include "Types.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#include <x86intrin.h>
+#endif
+
+// --- Cheap hot-path timestamps ---
+//
+// tsc_now() reads the CPU's invariant counter (rdtsc on x86, cntvct_el0 on
+// arm64): a few ns and no syscall/vDSO work, versus tens of ns for
+// steady_clock::now(). Raw ticks are what the hot path stores; TscClock
+// converts them to ns later, off the matching thread.
+//
+// On x86 the counter is only usable if it is invariant (constant rate and
+// running in deep C-states: CPUID 0x80000007 EDX bit 8, Linux's
+// constant_tsc + nonstop_tsc). Without that, tsc_now() falls back to
+// steady_clock, so stamps stay comparable at a higher cost per read.
+
+using TscTicks = std::uint64_t;
+
+namespace tsc_detail {
+
+inline bool invariant_tsc() {
+#if defined(__x86_64__) || defined(__i386__)
+    unsigned a, b, c, d;
+    if (!__get_cpuid(0x80000000u, &a, &b, &c, &d) || a < 0x80000007u) return false;
+    __get_cpuid(0x80000007u, &a, &b, &c, &d);
+    return (d >> 8) & 1;
+#elif defined(__aarch64__)
+    return true; // the generic timer runs at a fixed frequency by definition
+#else
+    return false;
+#endif
+}
+
+inline const bool use_tsc = invariant_tsc();
+
+} // namespace tsc_detail
+
+inline TscTicks tsc_now() {
+#if defined(__x86_64__) || defined(__i386__)
+    if (tsc_detail::use_tsc) [[likely]] return __rdtsc();
+    return static_cast<TscTicks>(Clock::now().time_since_epoch().count());
+#elif defined(__aarch64__)
+    TscTicks v;
+    asm volatile("mrs %0, cntvct_el0" : "=r"(v));
+    return v;
+#else
+    return static_cast<TscTicks>(Clock::now().time_since_epoch().count());
+#endif
+}
+
+class TscClock {
+public:
+    // What tsc_now() reads: "tsc" or, without an invariant counter, "steady_clock".
+    static const char *source() { return tsc_detail::use_tsc ? "tsc" : "steady_clock"; }
+
+    // Measures ticks per ns against steady_clock once; call at startup so the
+    // first conversion doesn't pay for it.
+    static void calibrate() { (void)get(); }
+
+    static double ns_per_tick() { return get().ns_per_tick; }
+
+    // Elapsed ns between two stamps.
+    static std::int64_t to_ns(TscTicks from, TscTicks to) {
+        return scale(static_cast<std::int64_t>(to - from));
+    }
+
+    // Maps a stamp onto the steady_clock timeline.
+    static TimePoint to_time_point(TscTicks t) {
+        const Calibration &cal = get();
+        auto ns = scale(static_cast<std::int64_t>(t - cal.base_ticks));
+        return cal.base_time + std::chrono::duration_cast<Clock::duration>(std::chrono::nanoseconds(ns));
+    }
+
+private:
+    struct Calibration {
+        double    ns_per_tick{1.0};
+        TscTicks  base_ticks{};
+        TimePoint base_time{};
+    };
+
+    static std::int64_t scale(std::int64_t ticks) {
+        return static_cast<std::int64_t>(static_cast<double>(ticks) * get().ns_per_tick);
+    }
+
+    static Calibration measure(std::chrono::milliseconds window = std::chrono::milliseconds(20)) {
+        auto t0 = Clock::now();
+        TscTicks c0 = tsc_now();
+        while (Clock::now() - t0 < window) {}
+        auto t1 = Clock::now();
+        TscTicks c1 = tsc_now();
+        double ns = std::chrono::duration<double, std::nano>(t1 - t0).count();
+        return {ns / static_cast<double>(c1 - c0), c1, t1};
+    }
+
+    static const Calibration &get() {
+        static const Calibration cal = measure();
+        return cal;
+    }
+};
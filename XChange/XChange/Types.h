@@ -6,6 +6,7 @@
 //
 #pragma once
 
+#include <algorithm>
 #include <chrono>
 #include <atomic>
 #include <condition_variable>
@@ -13,12 +14,16 @@
 #include <deque>
 #include <functional>
 #include <iostream>
+#include <limits>
 #include <map>
+#include <memory_resource>
 #include <mutex>
 #include <optional>
 #include <queue>
 #include <string>
 #include <thread>
+#include <tuple>
+#include <type_traits>
 #include <unordered_map>
 #include <vector>
 
@@ -28,17 +33,20 @@ using Clock = std::chrono::steady_clock;
 using TimePoint = std::chrono::time_point<Clock>;
 
 using OrderId = std::uint64_t;
+using InstrumentId = std::uint32_t;
 using Price   = std::int64_t;  // integer ticks
 using Qty     = std::int64_t;  // positive quantity
 
-enum class Side { Buy = 0, Sell = 1 };
+// 64-bit so that Order, which is journaled and replicated as raw bytes, has
+// no padding.
+enum class Side : std::uint64_t { Buy = 0, Sell = 1 };
 
 struct Order {
     OrderId    id{};
     Side       side{};
     Price      price{};
     Qty        qty{};
-    TimePoint  ts{Clock::now()};
+    TimePoint  ts{};   // caller's timestamp, not used for matching; engine latency stamps use TscClock
 };
 
 struct Trade {
@@ -47,3 +55,104 @@ struct Trade {
     Price   price{};
     Qty     qty{};
 };
+
+// Per-taker totals of one add_order(): what a consumer that only wants fills
+// (not the individual makers) needs. Filled in by the crossing loop itself.
+struct ExecutionSummary {
+    OrderId       taker_id{};
+    Side          side{};
+    Qty           filled_qty{};
+    Qty           leaves_qty{};     // rested on the book after matching
+    std::int64_t  notional{};       // sum of price * qty, in ticks
+    std::uint32_t fills{};          // makers hit
+    std::uint32_t levels_touched{};
+    Price         first_price{};    // first and last level traded at
+    Price         last_price{};
+
+    void record(Price px, Qty qty) {
+        if (fills++ == 0) first_price = px;
+        last_price = px;
+        filled_qty += qty;
+        notional += px * qty;
+    }
+
+    double vwap() const { return filled_qty ? static_cast<double>(notional) / static_cast<double>(filled_qty) : 0.0; }
+};
+
+// Price bands and circuit breaker, in basis points of a reference price.
+// A zero bps value turns that check off.
+struct PriceControls {
+    Price                    reference{};
+    std::int64_t             band_bps{};      // reject orders priced further than this from reference
+    std::int64_t             halt_move_bps{}; // halt if a trade would print this far from the window's anchor
+    std::chrono::nanoseconds halt_window{std::chrono::seconds(1)}; // anchor moves to the last trade this often
+};
+
+// Hidden orders rest in a separate FIFO per level, matched after the lit
+// queue at the same price, and never appear in depth or market data.
+enum class Display : std::uint8_t { Lit, Hidden };
+
+enum class AddResult : std::uint8_t {
+    Accepted,
+    Rejected, // outside the price band; the book is unchanged
+    Halted,   // accepted, but its next fill would have tripped the breaker; the rest rests for the auction
+};
+
+// --- Sequenced input (what the matcher applies, in match order) ---
+using SeqNo = std::uint64_t;
+using RequestId = std::uint64_t; // client-chosen; 0 = no ack wanted
+
+// Body of a Controls command: PriceControls in fixed-width fields, and
+// whether the instrument opens halted (in auction). Trivial, as a union
+// member next to Order must be; value-initialise it.
+struct ControlsFields {
+    Price         reference;
+    std::int64_t  band_bps;
+    std::int64_t  halt_move_bps;
+    std::int64_t  halt_window_ns;
+    std::uint64_t halt; // 0 or 1; 64-bit so it fills Order's footprint
+};
+static_assert(sizeof(ControlsFields) == sizeof(Order), "ControlsFields shares Command's storage with Order");
+
+struct Command {
+    // Replace cancels `replaces` and, only if it was resting, adds `order`.
+    // Controls sets the book's price controls from `controls`.
+    // Resume takes the book out of a halt, uncrossing it.
+    enum class Type : std::uint8_t { NewOrder = 0, Cancel = 1, Replace = 2, Controls = 3, Resume = 4 };
+    SeqNo         seq{};                 // assigned by the matcher, starts at 1
+    Type          type{Type::NewOrder};
+    Display       display{Display::Lit};  // NewOrder and Replace
+    std::uint16_t reserved0{};           // explicit, so no byte of a record is padding
+    InstrumentId  instrument{};          // which book; 0 for single-book engines
+    union {
+        Order          order{};          // NewOrder, Cancel (only order.id), Replace
+        ControlsFields controls;         // Controls
+    };
+    std::uint64_t ingress_tsc{};         // tsc_now() at submit
+    RequestId     request{};             // echoed in the Ack
+    OrderId       replaces{};            // for Replace
+    std::int64_t  clock_ns{};            // matcher's clock when sequenced; drives the breaker window
+    std::uint32_t reserved1{};
+    std::uint32_t crc{};                 // journal records: CRC32C of the bytes before it
+};
+
+// Commands go to disk and over the wire as raw bytes (and are checksummed
+// as such); every byte must be a field, or records would carry whatever
+// the stack held and differ run to run.
+static_assert(std::has_unique_object_representations_v<Command>, "Command must have no padding");
+
+// The matcher sequences a Controls command whenever it takes up new
+// reference data, so a standby or a replay bands and halts from the same
+// point in the stream as the primary did.
+inline Command controls_command(const PriceControls &pc, bool halt) {
+    Command c{};
+    c.type = Command::Type::Controls;
+    c.controls = ControlsFields{pc.reference, pc.band_bps, pc.halt_move_bps,
+                                static_cast<std::int64_t>(pc.halt_window.count()), halt};
+    return c;
+}
+
+inline PriceControls command_controls(const Command &c) {
+    return PriceControls{c.controls.reference, c.controls.band_bps, c.controls.halt_move_bps,
+                         std::chrono::nanoseconds(c.controls.halt_window_ns)};
+}
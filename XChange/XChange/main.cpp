@@ -10,102 +10,29 @@
 // Uses std::thread + atomic<bool> and a queue close() for clean shutdown.
 // Build: g++ -std=c++20 engine.cpp -pthread
 
-#include "OrderBook.h"
+#include "AsyncJournal.h"
+#include "AsyncOrderBook.h"
+#include "Backtest.h"
+#include "DiffFuzz.h"
+#include "Fix.h"
+#include "FlightRecorder.h"
+#include "HugePageArena.h"
+#include "Metrics.h"
+#include "Pegs.h"
+#include "PersistentOrderBook.h"
+#include "Replayer.h"
+#include "Replication.h"
+#include "Sbe.h"
+#include "Spreads.h"
+#include "TradeStats.h"
 
-// --- ConcurrentQueue for async ingress/egress (MPMC, mutex+cv) ---
-template <typename T>
-class ConcurrentQueue {
-public:
-    void push(T v) {
-        {
-            std::lock_guard<std::mutex> lk(m_);
-            if (closed_) return; // drop if closed
-            q_.push(std::move(v));
-        }
-        cv_.notify_one();
-    }
-
-    // Blocking pop; returns false if queue closed and empty
-    bool pop(T &out) {
-        std::unique_lock<std::mutex> lk(m_);
-        cv_.wait(lk, [&]{ return closed_ || !q_.empty(); });
-        if (q_.empty()) return false; // closed and drained
-        out = std::move(q_.front());
-        q_.pop();
-        return true;
-    }
-
-    bool try_pop(T &out) {
-        std::lock_guard<std::mutex> lk(m_);
-        if (q_.empty()) return false;
-        out = std::move(q_.front());
-        q_.pop();
-        return true;
-    }
-
-    void close() {
-        {
-            std::lock_guard<std::mutex> lk(m_);
-            closed_ = true;
-        }
-        cv_.notify_all();
-    }
-
-private:
-    std::mutex m_;
-    std::condition_variable cv_;
-    std::queue<T> q_;
-    bool closed_ = false;
-};
-
-struct EngineEvent {
-    enum class Type { TradeBatch, BookSnapshot } type{Type::TradeBatch};
-    std::vector<Trade> trades; // for TradeBatch
-};
-
-// --- Async wrapper around OrderBook ---
-class AsyncMatchingEngine {
-public:
-    AsyncMatchingEngine() : running_(true), worker_([this]{ run(); }) {}
-    ~AsyncMatchingEngine() {
-        shutdown();
-    }
-
-    void submit(Order o) { inq_.push(std::move(o)); }
-
-    bool poll_event(EngineEvent &ev) { return outq_.try_pop(ev); }
-
-    // Optional blocking wait (not used in this demo)
-    bool wait_event(EngineEvent &ev) { return outq_.pop(ev); }
-
-    std::optional<Price> best_bid() const { return book_.best_bid(); }
-    std::optional<Price> best_ask() const { return book_.best_ask(); }
-
-    void shutdown() {
-        bool expected = true;
-        if (running_.compare_exchange_strong(expected, false)) {
-            inq_.close();   // wake worker waiting on pop
-            if (worker_.joinable()) worker_.join();
-            outq_.close();  // wake any consumers
-        }
-    }
-
-private:
-    void run() {
-        while (running_) {
-            Order o;
-            if (!inq_.pop(o)) break; // queue closed & drained
-            auto trades = book_.add_order(std::move(o));
-            if (!trades.empty()) outq_.push(EngineEvent{EngineEvent::Type::TradeBatch, std::move(trades)});
-        }
-    }
-
-    OrderBook book_{};
-    ConcurrentQueue<Order> inq_{};
-    ConcurrentQueue<EngineEvent> outq_{};
-    std::atomic<bool> running_{false};
-    std::thread worker_;
-};
+#include <algorithm>
+#include <csignal>
+#include <cstdio>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <sys/wait.h>
 
 // --- Demos ---
 int main_async_demo() {
@@ -170,10 +97,1815 @@ int main_sync_demo() {
     return 0;
 }
 
-int main() {
+// Primary engine + hot standby over a socketpair; checks both sides produced
+// byte-identical trades. The instrument has a tick and a band, so some
+// orders are rejected and never reach the standby.
+int main_replication_demo() {
+    int fds[2];
+    if (::socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0) {
+        std::perror("socketpair");
+        return 1;
+    }
+
+    std::vector<Trade> standby_trades;
+    ReplicationStandby standby(fds[1], AckMode::Applied,
+                               [&](const Trade &t){ standby_trades.push_back(t); });
+    ReplicationPrimary primary(fds[0], ReplicationConfig{AckMode::Applied, 64});
+
+    std::vector<Trade> primary_trades;
+    RequestId submitted = 0;
+    SeqNo last_seq = 0;
+    std::size_t rejected = 0;
+    {
+        AsyncMatchingEngine eng(primary.sink());
+        InstrumentSpec spec;
+        spec.tick = 2;
+        spec.controls = PriceControls{100, 400, 0}; // 96..104
+        eng.set_instrument(spec);
+        OrderId id = 1;
+        for (int i = 0; i < 2000; ++i) {
+            Side s = (i % 2) ? Side::Sell : Side::Buy;
+            Price p = 100 + (i * 7) % 11 - 5;
+            eng.submit(Order{ id++, s, p, 1 + (i * 13) % 50, Clock::now() }, Display::Lit, ++submitted);
+            if (i % 5 == 0) eng.cancel(id - 3, ++submitted);
+        }
+        std::size_t acks = 0;
+        EngineEvent ev;
+        while (acks < submitted && eng.wait_event(ev)) {
+            primary_trades.insert(primary_trades.end(), ev.trades.begin(), ev.trades.end());
+            for (auto const &a : ev.acks) {
+                last_seq = std::max(last_seq, a.seq);
+                rejected += a.status == AckStatus::Rejected;
+            }
+            acks += ev.acks.size();
+        }
+        primary.wait_acked(last_seq);
+        eng.shutdown();
+        while (eng.poll_event(ev))
+            primary_trades.insert(primary_trades.end(), ev.trades.begin(), ev.trades.end());
+    }
+    primary.close();
+    standby.join();
+
+    bool same = !standby.failed() && standby.applied_seq() == last_seq
+        && primary_trades.size() == standby_trades.size()
+        && std::memcmp(primary_trades.data(), standby_trades.data(),
+                       primary_trades.size() * sizeof(Trade)) == 0;
+    std::cout << "commands=" << submitted << " rejected=" << rejected
+              << " applied=" << standby.applied_seq()
+              << " trades=" << primary_trades.size()
+              << " identical=" << (same ? "yes" : "NO") << "\n";
+    return same ? 0 : 1;
+}
+
+// Deterministic mixed order/cancel stream used by the persistence demo.
+Command demo_command(SeqNo seq) {
+    Command c{};
+    c.seq = seq;
+    if (seq % 4 == 0) {
+        c.type = Command::Type::Cancel;
+        c.order.id = seq - 3;
+        return c;
+    }
+    c.order = Order{ seq, (seq % 3) ? Side::Buy : Side::Sell,
+                     100 + static_cast<Price>((seq * 7919) % 21) - 10,
+                     1 + static_cast<Qty>((seq * 31) % 40), TimePoint{} };
+    return c;
+}
+
+// Child writes journal + mapped book and is SIGKILLed mid-stream; the parent
+// remaps, rolls forward and checks the result against a plain OrderBook.
+int main_persist_demo() {
+    const std::string book_path = "/tmp/xchange_book.dat";
+    const std::string jnl_path  = "/tmp/xchange_book.jnl";
+    std::remove(book_path.c_str());
+    std::remove(jnl_path.c_str());
+    PersistentBookConfig cfg{1u << 16, 1u << 10, 1u << 16};
+
+    pid_t child = ::fork();
+    if (child == 0) {
+        PersistentOrderBook book(book_path, cfg);
+        JournalWriter jnl(jnl_path);
+        for (SeqNo seq = 1;; ++seq) {
+            Command c = demo_command(seq);
+            jnl.append(c);
+            jnl.flush(); // write-ahead
+            book.apply(c);
+        }
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    ::kill(child, SIGKILL);
+    ::waitpid(child, nullptr, 0);
+
+    auto t0 = Clock::now();
+    auto book = std::make_unique<PersistentOrderBook>(book_path);
+    auto t1 = Clock::now();
+    JournalReader jnl(jnl_path);
+    std::size_t rolled = book->roll_forward(jnl);
+    auto t2 = Clock::now();
+
+    OrderBook ref;
+    JournalReader replay(jnl_path);
+    Command c;
+    while (replay.next(c)) {
+        if (c.type == Command::Type::Cancel) ref.cancel(c.order.id);
+        else ref.add_order(c.order);
+    }
+    std::ostringstream a, b;
+    book->print_book(a);
+    ref.print_book(b);
+
+    using us = std::chrono::microseconds;
+    std::cout << "remap=" << std::chrono::duration_cast<us>(t1 - t0).count() << "us"
+              << " partial=" << (book->recovered_partial() ? "yes" : "no")
+              << " rolled_forward=" << rolled
+              << " (" << std::chrono::duration_cast<us>(t2 - t1).count() << "us)"
+              << " applied_seq=" << book->applied_seq()
+              << " matches_replay=" << (a.str() == b.str() ? "yes" : "NO") << "\n";
+
+    // A clean close seals the image; reopening verifies it, and a byte
+    // flipped at rest is refused.
+    book.reset();
+    t0 = Clock::now();
+    bool verified = PersistentOrderBook(book_path).verified();
+    t1 = Clock::now();
+    int fd = ::open(book_path.c_str(), O_RDWR);
+    char byte = 0;
+    ::pread(fd, &byte, 1, 200);
+    byte = static_cast<char>(byte ^ 1);
+    ::pwrite(fd, &byte, 1, 200);
+    ::close(fd);
+    bool refused = false;
+    try {
+        PersistentOrderBook damaged(book_path);
+    } catch (const std::runtime_error &e) {
+        refused = std::string(e.what()).find("checksum") != std::string::npos;
+    }
+    std::cout << "sealed image (" << crc32c_backend() << "): verified on reopen=" << (verified ? "yes" : "NO") << " ("
+              << std::chrono::duration_cast<us>(t1 - t0).count() << "us), flipped byte refused="
+              << (refused ? "yes" : "NO") << "\n";
+    return a.str() == b.str() && verified && refused ? 0 : 1;
+}
+
+// Cancel-heavy random workload over a ~1M order book: every step cancels a
+// random resting order and adds a fresh one, so the cancel path's random
+// index/level/queue accesses dominate.
+double bench_cancel_ns(OrderBook &ob) {
+    constexpr std::size_t kResting = 1u << 20;
+    constexpr std::size_t kSteps   = 1u << 19;
+    constexpr Price kLevels = 1 << 17;
+    std::mt19937_64 rng(42);
+    std::vector<OrderId> live(kResting);
+    OrderId next_id = 1;
+    TimePoint ts{};
+    for (auto &id : live) {
+        id = next_id++;
+        ob.add_order(Order{ id, Side::Buy, 1 + static_cast<Price>(rng() % kLevels), 10, ts });
+    }
+    std::vector<std::pair<std::size_t, Price>> ops(kSteps);
+    for (auto &op : ops) op = { rng() % kResting, 1 + static_cast<Price>(rng() % kLevels) };
+
+    auto t0 = Clock::now();
+    for (auto const &[slot, px] : ops) {
+        ob.cancel(live[slot]);
+        live[slot] = next_id++;
+        ob.add_order(Order{ live[slot], Side::Buy, px, 10, ts });
+    }
+    auto t1 = Clock::now();
+    return std::chrono::duration<double, std::nano>(t1 - t0).count() / kSteps;
+}
+
+int main_bench_cancel() {
+    {
+        OrderBook ob;
+        std::cout << "heap:           " << bench_cancel_ns(ob) << " ns/(cancel+add)\n";
+    }
+    {
+        std::pmr::unsynchronized_pool_resource pool;
+        OrderBook ob{&pool};
+        std::cout << "pool over heap: " << bench_cancel_ns(ob) << " ns/(cancel+add)\n";
+    }
+    {
+        HugePageResource huge;
+        std::pmr::unsynchronized_pool_resource pool{&huge};
+        OrderBook ob{&pool};
+        std::cout << "pool over 2MB:  " << bench_cancel_ns(ob) << " ns/(cancel+add)\n";
+        auto st = huge.stats();
+        std::cout << "  mapped=" << (st.bytes_mapped >> 20) << "MB"
+                  << " hugetlb=" << st.explicit_chunks
+                  << " thp=" << st.transparent_chunks
+                  << " regular=" << st.regular_chunks << " chunks\n";
+    }
+    return 0;
+}
+
+// Per-call cost of the two clocks, then engine stage latencies from TSC
+// stamps converted to ns after the run.
+int main_latency_demo() {
+    TscClock::calibrate();
+    constexpr int kCalls = 1 << 22;
+    std::uint64_t sink = 0;
+    auto t0 = Clock::now();
+    for (int i = 0; i < kCalls; ++i) sink += static_cast<std::uint64_t>(Clock::now().time_since_epoch().count());
+    auto t1 = Clock::now();
+    for (int i = 0; i < kCalls; ++i) sink += tsc_now();
+    auto t2 = Clock::now();
+    std::cout << "steady_clock::now " << std::chrono::duration<double, std::nano>(t1 - t0).count() / kCalls << " ns, "
+              << "tsc_now " << std::chrono::duration<double, std::nano>(t2 - t1).count() / kCalls << " ns"
+              << " (" << TscClock::source() << ", " << TscClock::ns_per_tick() << " ns/tick, sink " << (sink & 1) << ")\n";
+
+    std::vector<EngineStamps> stamps;
+    {
+        AsyncMatchingEngine eng;
+        std::thread consumer([&] { // egress is stamped as events are taken
+            for (EngineEvent ev; eng.wait_event(ev);) stamps.push_back(ev.stamps);
+        });
+        for (OrderId id = 1; id <= 20000; ++id) {
+            eng.submit(Order{ id, Side::Sell, 100, 1, {} });
+            eng.submit(Order{ id + 1000000, Side::Buy, 100, 1, {} }); // crosses
+            if (id % 64 == 0) std::this_thread::sleep_for(std::chrono::microseconds(50));
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        eng.shutdown();
+        consumer.join();
+    }
+    auto report = [&](const char *name, auto from, auto to) {
+        std::vector<std::int64_t> ns;
+        ns.reserve(stamps.size());
+        for (auto const &s : stamps) ns.push_back(TscClock::to_ns(s.*from, s.*to));
+        if (ns.empty()) return;
+        std::sort(ns.begin(), ns.end());
+        std::cout << "  " << name << " p50=" << ns[ns.size() / 2]
+                  << " p99=" << ns[ns.size() * 99 / 100]
+                  << " max=" << ns.back() << " ns\n";
+    };
+    std::cout << stamps.size() << " events\n";
+    report("queue  (ingress->match_start)", &EngineStamps::ingress, &EngineStamps::match_start);
+    report("match  (match_start->end)    ", &EngineStamps::match_start, &EngineStamps::match_end);
+    report("egress (match_end->consumer) ", &EngineStamps::match_end, &EngineStamps::egress);
+    report("total  (ingress->consumer)   ", &EngineStamps::ingress, &EngineStamps::egress);
+    return 0;
+}
+
+// Records a short engine run, dumps it via SIGUSR1 and decodes the tail.
+int main_flight_demo() {
+    const char *path = "/tmp/xchange.flight";
+    FlightRecorder::enable(1u << 12);
+    FlightRecorder::dump_on_signal(path);
+    {
+        AsyncMatchingEngine eng;
+        for (OrderId id = 1; id <= 3000; ++id)
+            eng.submit(Order{ id, (id % 2) ? Side::Buy : Side::Sell, 100 + static_cast<Price>(id % 3), 5, {} });
+        eng.cancel(2999);
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        eng.shutdown();
+    }
+    std::raise(SIGUSR1);
+
+    std::ostringstream text;
+    if (!flight_decode(path, text)) {
+        std::cerr << "cannot decode " << path << "\n";
+        return 1;
+    }
+    std::vector<std::string> lines;
+    std::istringstream in(text.str());
+    for (std::string l; std::getline(in, l);) lines.push_back(l);
+    std::cout << lines.size() << " events in " << path << ", last 12:\n";
+    for (std::size_t i = lines.size() > 12 ? lines.size() - 12 : 0; i < lines.size(); ++i)
+        std::cout << "  " << lines[i] << "\n";
+    return 0;
+}
+
+// Serves metrics while an engine runs, then scrapes the endpoint once
+// (serves until killed when given a port).
+int main_metrics_demo(std::uint16_t port) {
+    { // an engine that has come and gone: its book gauges leave with its worker
+        AsyncMatchingEngine old;
+        old.submit(Order{ 1, Side::Buy, 90, 1, {} }, Display::Lit, 1);
+        EngineEvent ev;
+        while (old.wait_event(ev) && ev.type != EngineEvent::Type::Acks) {}
+    }
+    HugePageResource huge;
+    AsyncMatchingEngine eng({}, &huge);
+    MetricsServer server(port);
+    server.add_gauge("xchange_inbound_queue_depth", "Commands waiting for the matcher",
+                     [&]{ return static_cast<double>(eng.inbound_depth()); });
+    server.add_gauge("xchange_outbound_queue_depth", "Events waiting for consumers",
+                     [&]{ return static_cast<double>(eng.outbound_depth()); });
+    server.add_gauge("xchange_arena_bytes_mapped", "Hugepage arena bytes mapped",
+                     [&]{ return static_cast<double>(huge.stats().bytes_mapped); });
+    server.start();
+    std::cout << "metrics on http://127.0.0.1:" << server.port() << "/metrics\n";
+
+    std::mt19937_64 rng(7);
+    for (OrderId id = 1; id <= 50000; ++id) {
+        eng.submit(Order{ id, (rng() & 1) ? Side::Buy : Side::Sell, 95 + static_cast<Price>(rng() % 11), 1 + static_cast<Qty>(rng() % 9), {} });
+        if (id % 7 == 0) eng.cancel(id - 5);
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    std::cout << "book gauge series: " << EngineMetrics::collect().gauges.size() << " (live engines)\n";
+
+    if (port != 0) {
+        for (;;) std::this_thread::sleep_for(std::chrono::seconds(1));
+    }
+    int c = ::socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(server.port());
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (::connect(c, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) != 0) {
+        std::perror("connect");
+        return 1;
+    }
+    const char req[] = "GET /metrics HTTP/1.1\r\nHost: localhost\r\n\r\n";
+    (void)::write(c, req, sizeof(req) - 1);
+    std::string resp;
+    char buf[4096];
+    for (ssize_t n; (n = ::read(c, buf, sizeof(buf))) > 0;) resp.append(buf, static_cast<std::size_t>(n));
+    ::close(c);
+    std::cout << resp.substr(0, 2000) << "\n";
+    eng.shutdown();
+    return 0;
+}
+
+// Variants for streams of up to `max_ops` ops. PersistentOrderBook's pools
+// are fixed, so they are sized from that: an order slot per op, and undo
+// room for one command filling every resting order (a few stores each).
+// Fuzz prices span a few ticks, so 256 levels is plenty.
+DifferentialFuzzer make_fuzzer(std::size_t max_ops) {
+    static HugePageResource huge;
+    static std::pmr::unsynchronized_pool_resource pool{&huge};
+    DifferentialFuzzer fz;
+    fz.add_variant("OrderBook/hugepage-pool", []{ return std::make_unique<FuzzAdapter<OrderBook>>(&pool); });
+    auto orders = static_cast<std::uint32_t>(std::max<std::size_t>(max_ops, 16));
+    PersistentBookConfig cfg{orders, 1u << 8, 16 * orders + 1024};
+    fz.add_variant("PersistentOrderBook", [cfg]{
+        const char *path = "/tmp/xchange_fuzz.book";
+        std::remove(path);
+        return std::make_unique<FuzzAdapter<PersistentOrderBook>>(path, cfg);
+    });
+    return fz;
+}
+
+// Reference OrderBook vs each optimized book over random streams, plus a
+// self-check that an injected bug is caught and shrunk.
+int main_fuzz_demo(std::size_t total_ops) {
+    constexpr std::size_t kStream = 5000;
+    DifferentialFuzzer fz = make_fuzzer(kStream);
+    auto t0 = Clock::now();
+    std::size_t done = 0;
+    for (std::uint64_t seed = 1; done < total_ops; ++seed, done += kStream) {
+        auto ops = DifferentialFuzzer::random_ops(seed, kStream);
+        if (auto f = fz.run(ops)) {
+            std::cout << "seed " << seed << ": " << f->variant << " diverged at step " << f->step << "\n";
+            auto small = fz.shrink(ops);
+            std::cout << "shrunk to " << small.size() << " ops:\n";
+            DifferentialFuzzer::print_ops(small, std::cout);
+            std::cout << fz.run(small)->detail;
+            return 1;
+        }
+    }
+    double sec = std::chrono::duration<double>(Clock::now() - t0).count();
+    std::cout << done << " ops through reference + 2 variants, no divergence, "
+              << static_cast<std::uint64_t>(static_cast<double>(done) / sec) << " ops/s\n";
+
+    // The harness must catch and minimise a real difference.
+    struct DropsSomeCancels : FuzzAdapter<OrderBook> {
+        bool cancel(OrderId id) override { return id % 53 == 0 ? false : FuzzAdapter<OrderBook>::cancel(id); }
+    };
+    DifferentialFuzzer broken;
+    broken.add_variant("DropsSomeCancels", []{ return std::make_unique<DropsSomeCancels>(); });
+    for (std::uint64_t seed = 1; seed < 100; ++seed) {
+        auto ops = DifferentialFuzzer::random_ops(seed, kStream);
+        if (auto f = broken.run(ops)) {
+            auto small = broken.shrink(ops);
+            std::cout << "self-check: injected bug caught at step " << f->step
+                      << ", shrunk to " << small.size() << " ops:\n";
+            DifferentialFuzzer::print_ops(small, std::cout);
+            return 0;
+        }
+    }
+    std::cout << "self-check FAILED: injected bug not caught\n";
+    return 1;
+}
+
+// Writes `n` synthetic L3 events (adds/cancels around a drifting mid per
+// instrument) in journal format.
+void write_synthetic_day(const std::string &path, std::size_t n, std::uint64_t seed,
+                         InstrumentId instruments = 1) {
+    std::remove(path.c_str());
+    JournalWriter out(path);
+    std::mt19937_64 rng(seed);
+    std::vector<std::vector<OrderId>> live(instruments);
+    std::vector<Price> mid(instruments, 10000);
+    TimePoint ts{};
+    std::int64_t clock_ns = 0;
+    for (SeqNo seq = 1; seq <= n; ++seq) {
+        std::uint64_t r = rng();
+        ts += std::chrono::microseconds(1 + r % 50);
+        if (seq % 16 == 1) clock_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(ts.time_since_epoch()).count(); // per batch
+        Command c{};
+        c.seq = seq;
+        c.instrument = static_cast<InstrumentId>((r >> 50) % instruments);
+        auto &ids = live[c.instrument];
+        if ((r & 3) == 0 && !ids.empty()) {
+            std::size_t k = (r >> 8) % ids.size();
+            c.type = Command::Type::Cancel;
+            c.order.id = ids[k];
+            ids[k] = ids.back();
+            ids.pop_back();
+        } else {
+            Price &m = mid[c.instrument];
+            if ((r >> 40) % 64 == 0) m += ((r >> 46) & 1) ? 1 : -1;
+            Side side = ((r >> 2) & 1) ? Side::Sell : Side::Buy;
+            Price off = static_cast<Price>((r >> 16) % 12) - 2; // a few cross
+            c.order = Order{ seq, side, side == Side::Buy ? m - off : m + off,
+                             1 + static_cast<Qty>((r >> 24) % 10), ts };
+            ids.push_back(seq);
+        }
+        c.order.ts = ts;
+        c.clock_ns = clock_ns;
+        out.append(c);
+    }
+}
+
+// Quotes one lot at the touch on both sides, re-quoting every 1000 events.
+class TouchQuoter : public Strategy {
+public:
+    void on_event(const Command &, BacktestContext &ctx) override {
+        if (++events_ % 1000 != 0) return;
+        ctx.cancel(bid_id_);
+        ctx.cancel(ask_id_);
+        if (auto b = ctx.best_bid()) ctx.submit(bid_id_ = ++next_id_, Side::Buy, *b, 1);
+        if (auto a = ctx.best_ask()) ctx.submit(ask_id_ = ++next_id_, Side::Sell, *a, 1);
+    }
+    void on_fill(const Trade &t, bool, BacktestContext &) override { position_ += t.qty; }
+
+private:
+    std::uint64_t events_ = 0;
+    OrderId next_id_ = 0, bid_id_ = 0, ask_id_ = 0;
+    Qty position_ = 0;
+};
+
+int main_backtest_demo(std::size_t events_per_day, unsigned days) {
+    std::vector<std::string> paths;
+    for (unsigned d = 0; d < days; ++d) {
+        paths.push_back("/tmp/xchange_day" + std::to_string(d) + ".jnl");
+        write_synthetic_day(paths.back(), events_per_day, 1000 + d);
+    }
+    TouchQuoter single;
+    BacktestResult one = Backtester::run(paths[0], single);
+    std::cout << "single day: " << one.events << " events, " << one.trades << " trades, "
+              << one.strategy_fills << " strategy fills, "
+              << static_cast<std::uint64_t>(one.events_per_sec()) << " events/s\n";
+
+    unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+    auto t0 = Clock::now();
+    auto all = Backtester::run_parallel(paths, []{ return std::make_unique<TouchQuoter>(); }, threads);
+    double sec = std::chrono::duration<double>(Clock::now() - t0).count();
+    std::uint64_t total = 0;
+    for (auto const &r : all) total += r.events;
+    std::cout << days << " days on " << threads << " threads: "
+              << static_cast<std::uint64_t>(static_cast<double>(total) / sec) << " events/s aggregate\n";
+    return 0;
+}
+
+// Replays one multi-instrument journal with 1..N workers; every worker
+// count must give the same per-instrument trade streams.
+int main_replay_demo(std::size_t events, InstrumentId instruments) {
+    const std::string path = "/tmp/xchange_replay.jnl";
+    write_synthetic_day(path, events, 77, instruments);
+    unsigned max_workers = std::max(4u, std::thread::hardware_concurrency());
+    std::vector<InstrumentReplayResult> baseline;
+    for (unsigned w = 1; w <= max_workers; w *= 2) {
+        ParallelReplayer replayer(w);
+        auto t0 = Clock::now();
+        auto res = replayer.replay(path);
+        double sec = std::chrono::duration<double>(Clock::now() - t0).count();
+        bool same = baseline.empty() || (res.size() == baseline.size()
+            && std::equal(res.begin(), res.end(), baseline.begin(), [](auto const &a, auto const &b) {
+                   return a.instrument == b.instrument && a.trades == b.trades && a.trade_hash == b.trade_hash; }));
+        if (baseline.empty()) baseline = res;
+        std::cout << w << " worker(s): " << static_cast<std::uint64_t>(static_cast<double>(events) / sec)
+                  << " events/s, " << res.size() << " instruments, deterministic="
+                  << (same ? "yes" : "NO") << "\n";
+        if (!same) return 1;
+    }
+    std::cout << "(" << std::thread::hardware_concurrency() << " hardware threads)\n";
+    return 0;
+}
+
+// Engine throughput with the worker taking 1 vs up to N commands per
+// wake-up. The flow mixes passive runs at one price with aggressive sweeps.
+int main_bench_batch(std::size_t n) {
+    std::vector<Order> flow;
+    flow.reserve(n);
+    std::mt19937_64 rng(3);
+    for (OrderId id = 1; flow.size() < n; ++id) {
+        std::uint64_t r = rng();
+        Side s = (id / 16) % 2 ? Side::Sell : Side::Buy; // runs of 16 per side
+        bool aggressive = r % 8 == 0;
+        Price px = s == Side::Buy ? (aggressive ? 105 : 99 - static_cast<Price>(r % 2))
+                                  : (aggressive ? 95 : 101 + static_cast<Price>(r % 2));
+        flow.push_back(Order{ id, s, px, 1 + static_cast<Qty>(r % 5), {} });
+    }
+    for (std::size_t batch : {std::size_t{1}, std::size_t{16}, std::size_t{64}, std::size_t{256}}) {
+        std::atomic<SeqNo> applied{0};
+        AsyncMatchingEngine eng([&](const Command &c){ applied.store(c.seq, std::memory_order_relaxed); });
+        eng.set_max_batch(batch);
+        auto t0 = Clock::now();
+        for (auto const &o : flow) eng.submit(o);
+        while (applied.load(std::memory_order_relaxed) < n) {
+            EngineEvent ev;
+            while (eng.poll_event(ev)) {}
+            std::this_thread::yield();
+        }
+        double sec = std::chrono::duration<double>(Clock::now() - t0).count();
+        std::cout << "max_batch=" << batch << ": "
+                  << static_cast<std::uint64_t>(static_cast<double>(n) / sec) << " orders/s\n";
+        eng.shutdown();
+    }
+    return 0;
+}
+
+// One taker sweeping 50 makers over 5 levels, published per TradeReporting
+// mode: what reaches egress, and that the summary agrees with the trades.
+int main_exec_summary_demo() {
+    for (TradeReporting mode : {TradeReporting::Trades, TradeReporting::Summary, TradeReporting::Both}) {
+        std::atomic<SeqNo> applied{0};
+        AsyncMatchingEngine eng([&](const Command &c){ applied.store(c.seq, std::memory_order_relaxed); });
+        eng.set_trade_reporting(mode);
+        for (OrderId id = 1; id <= 50; ++id)
+            eng.submit(Order{ id, Side::Sell, 100 + static_cast<Price>((id - 1) / 10), 2, {} });
+        eng.submit(Order{ 1000, Side::Buy, 104, 120, {} });
+        while (applied.load(std::memory_order_relaxed) < 51) std::this_thread::yield();
+        eng.shutdown();
+
+        EngineEvent ev;
+        std::size_t events = 0, trades = 0, bytes = 0;
+        ExecutionSummary sum;
+        while (eng.poll_event(ev)) {
+            ++events;
+            trades += ev.trades.size();
+            bytes += ev.trades.size() * sizeof(Trade) + (ev.summary.fills ? sizeof(ExecutionSummary) : 0);
+            if (ev.summary.fills) sum = ev.summary;
+        }
+        const char *name = mode == TradeReporting::Trades ? "trades" : mode == TradeReporting::Summary ? "summary" : "both";
+        std::cout << name << ": events=" << events << " trades=" << trades << " egress_bytes=" << bytes;
+        if (sum.fills)
+            std::cout << " | taker=" << sum.taker_id << " filled=" << sum.filled_qty << " leaves=" << sum.leaves_qty
+                      << " fills=" << sum.fills << " levels=" << sum.levels_touched << " vwap=" << sum.vwap()
+                      << " px=" << sum.first_price << ".." << sum.last_price;
+        std::cout << "\n";
+    }
+    return 0;
+}
+
+// Engine -> consumer feeding TradeStatistics from execution summaries ->
+// reader polling the conflated channel. The final snapshot is checked
+// against totals recomputed from the per-maker trades.
+int main_stats_demo(std::size_t n) {
+    AsyncMatchingEngine eng;
+    eng.set_trade_reporting(TradeReporting::Both);
+    TradeStatistics stats(1, std::chrono::milliseconds(1));
+    TscClock::calibrate();
+
+    std::atomic<bool> done{false};
+    std::size_t reads = 0, distinct = 0;
+    std::thread reader([&]{
+        std::uint64_t seen = 0;
+        TradeStatsSnapshot s;
+        while (!done.load(std::memory_order_acquire)) {
+            if (stats.channel(0).version() == seen) { std::this_thread::yield(); continue; }
+            if (stats.read(0, s)) {
+                ++reads;
+                if (s.updates != seen) ++distinct;
+                seen = s.updates;
+            }
+        }
+    });
+
+    Qty volume = 0;
+    std::int64_t notional = 0;
+    std::uint64_t trades = 0;
+    Price last = 0;
+    std::thread consumer([&]{
+        EngineEvent ev;
+        while (eng.wait_event(ev)) {
+            auto ts = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                TscClock::to_time_point(ev.stamps.match_end).time_since_epoch()).count();
+            stats.on_execution(0, ev.summary, ts);
+            for (auto const &t : ev.trades) {
+                volume += t.qty;
+                notional += t.price * t.qty;
+                last = t.price;
+                ++trades;
+            }
+        }
+    });
+
+    std::mt19937_64 rng(11);
+    for (OrderId id = 1; id <= n; ++id) {
+        std::uint64_t r = rng();
+        Side side = r & 1 ? Side::Sell : Side::Buy;
+        Price px = 100 + static_cast<Price>((r >> 8) % 7) - 3;
+        eng.submit(Order{ id, side, px, 1 + static_cast<Qty>((r >> 16) % 10), {} });
+    }
+    while (eng.inbound_depth() > 0) std::this_thread::yield();
+    eng.shutdown();
+    consumer.join();
+    done.store(true, std::memory_order_release);
+    reader.join();
+
+    TradeStatsSnapshot s;
+    bool ok = stats.read(0, s) && s.volume == volume && s.notional == notional && s.trades == trades
+              && s.last_price == last;
+    std::cout << "trades=" << s.trades << " volume=" << s.volume << " vwap=" << s.vwap() << " last=" << s.last_price
+              << " updates=" << s.updates << "\n"
+              << "bar: O=" << s.bar.open << " H=" << s.bar.high << " L=" << s.bar.low << " C=" << s.bar.close
+              << " vol=" << s.bar.volume << " | prev: O=" << s.prev_bar.open << " H=" << s.prev_bar.high
+              << " L=" << s.prev_bar.low << " C=" << s.prev_bar.close << " vol=" << s.prev_bar.volume << "\n"
+              << "reader: " << reads << " reads, " << distinct << " distinct snapshots\n"
+              << "matches_trades=" << (ok ? "yes" : "NO") << "\n";
+    return ok ? 0 : 1;
+}
+
+// Reader threads pin depth snapshots while the engine matches; every view
+// must be internally consistent, and the last one must equal the depth of a
+// reference book fed the same flow.
+int main_depth_demo(std::size_t n) {
+    AsyncMatchingEngine eng;
+    eng.set_trade_reporting(TradeReporting::Summary);
+    eng.set_depth_view(true);
+
+    std::vector<Order> flow;
+    std::mt19937_64 rng(5);
+    for (OrderId id = 1; id <= n; ++id) {
+        std::uint64_t r = rng();
+        Side side = r & 1 ? Side::Sell : Side::Buy;
+        Price px = 100 + static_cast<Price>((r >> 8) % 21) - 10 + (side == Side::Sell ? 3 : -3);
+        flow.push_back(Order{ id, side, px, 1 + static_cast<Qty>((r >> 16) % 10), {} });
+    }
+
+    std::atomic<bool> done{false};
+    std::atomic<std::uint64_t> views{0}, bad{0};
+    std::vector<std::thread> readers;
+    for (int t = 0; t < 2; ++t) {
+        readers.emplace_back([&]{
+            auto reader = eng.depth_reader();
+            while (!done.load(std::memory_order_acquire)) {
+                auto snap = reader.pin();
+                if (!snap) { std::this_thread::yield(); continue; }
+                bool ok = true;
+                for (std::size_t i = 0; i < snap->bids.size(); ++i)
+                    ok &= snap->bids[i].qty > 0 && (i == 0 || snap->bids[i].price < snap->bids[i - 1].price);
+                for (std::size_t i = 0; i < snap->asks.size(); ++i)
+                    ok &= snap->asks[i].qty > 0 && (i == 0 || snap->asks[i].price > snap->asks[i - 1].price);
+                if (!snap->bids.empty() && !snap->asks.empty()) ok &= snap->bids[0].price < snap->asks[0].price;
+                views.fetch_add(1, std::memory_order_relaxed);
+                if (!ok) bad.fetch_add(1, std::memory_order_relaxed);
+            }
+        });
+    }
+
+    for (std::size_t i = 0; i < flow.size(); ++i) {
+        eng.submit(flow[i]);
+        if (i % 7 == 3) eng.cancel(flow[i - 2].id);
+    }
+    while (eng.inbound_depth() > 0) std::this_thread::yield();
+    auto last = eng.depth_reader();
+    SeqNo expect = n + n / 7;
+    for (;;) { // wait for the final batch to be published
+        auto snap = last.pin();
+        if (snap && snap->seq >= expect) break;
+        std::this_thread::yield();
+    }
+    done.store(true, std::memory_order_release);
+    for (auto &t : readers) t.join();
+
+    OrderBook ref;
+    for (std::size_t i = 0; i < flow.size(); ++i) {
+        ref.add_order(flow[i]);
+        if (i % 7 == 3) ref.cancel(flow[i - 2].id);
+    }
+    std::map<std::pair<int, Price>, std::pair<Qty, std::uint32_t>> want;
+    ref.for_each_resting([&](Side s, Price px, OrderId, Qty q) {
+        auto &w = want[{static_cast<int>(s), px}];
+        w.first += q;
+        ++w.second;
+    });
+    auto snap = last.pin();
+    std::map<std::pair<int, Price>, std::pair<Qty, std::uint32_t>> got;
+    for (auto const &l : snap->bids) got[{static_cast<int>(Side::Buy), l.price}] = {l.qty, l.orders};
+    for (auto const &l : snap->asks) got[{static_cast<int>(Side::Sell), l.price}] = {l.qty, l.orders};
+    bool same = got == want;
+    std::cout << "seq=" << snap->seq << " bid_levels=" << snap->bids.size() << " ask_levels=" << snap->asks.size()
+              << "\nreader views=" << views.load() << " inconsistent=" << bad.load()
+              << "\nmatches_reference=" << (same ? "yes" : "NO") << "\n";
+    return same && bad.load() == 0 ? 0 : 1;
+}
+
+// Band rejects, a sweep tripping the breaker, auction-mode resting and the
+// uncross on resume; then add_order() cost with controls off vs on.
+int main_bands_demo() {
+    OrderBook book;
+    TimePoint t0 = Clock::now();
+    book.set_price_controls(PriceControls{100, 500, 300, std::chrono::seconds(1)}); // band +-5, halt +-3
+    for (OrderId id = 1; id <= 5; ++id) book.add_order(Order{ id, Side::Sell, 100 + static_cast<Price>(id), 10, t0 });
+    std::vector<Trade> trades;
+    auto show = [](const char *what, AddResult r) {
+        std::cout << what << ": " << (r == AddResult::Accepted ? "accepted" : r == AddResult::Rejected ? "rejected" : "HALTED") << "\n";
+    };
+    show("buy 10@106 (outside band)", book.add_order(Order{ 10, Side::Buy, 106, 10, t0 }, trades));
+    show("replace sell 1 -> 94 (outside band)", *book.replace(1, Order{ 1, Side::Sell, 94, 10, t0 }, trades));
+    std::cout << "  original still resting: " << (book.locate(1) ? "yes" : "NO") << "\n";
+    show("buy 45@105 (sweep)", book.add_order(Order{ 11, Side::Buy, 105, 45, t0 }, trades));
+    std::cout << "  filled " << trades.size() << " makers, halted=" << (book.halted() ? "yes" : "no") << "\n";
+    trades.clear();
+    show("sell 20@102 (in auction)", book.add_order(Order{ 12, Side::Sell, 102, 20, t0 }, trades));
+    show("buy 5@104 (in auction)", book.add_order(Order{ 13, Side::Buy, 104, 5, t0 }, trades));
+    std::cout << "  trades during halt: " << trades.size() << "\n";
+    book.print_book();
+    auto px = book.resume(trades);
+    std::cout << "uncross at " << (px ? std::to_string(*px) : "-") << ":\n";
+    for (auto const &t : trades) std::cout << "  sell " << t.maker_id << " / buy " << t.taker_id << " " << t.qty << "@" << t.price << "\n";
+    book.print_book();
+
+    // The same session through the engine: the sweep is acked Halted and
+    // followed by a Halted event; resume() publishes the auction.
+    {
+        InstrumentSpec spec;
+        spec.controls = PriceControls{100, 500, 300, std::chrono::seconds(1)};
+        AsyncMatchingEngine eng;
+        eng.set_instrument(spec);
+        for (OrderId id = 1; id <= 5; ++id) eng.submit(Order{ id, Side::Sell, 100 + static_cast<Price>(id), 10, {} });
+        eng.submit(Order{ 11, Side::Buy, 105, 45, {} }, Display::Lit, 1);
+        eng.submit(Order{ 12, Side::Sell, 102, 20, {} }, Display::Lit, 2);
+        eng.submit(Order{ 13, Side::Buy, 104, 5, {} }, Display::Lit, 3);
+        eng.resume(4);
+        static const char *status_names[] = {"accepted", "rejected", "cancelled", "cancel-rejected", "halted"};
+        std::cout << "engine:\n";
+        for (EngineEvent ev; eng.wait_event(ev);) {
+            if (ev.type == EngineEvent::Type::Acks)
+                for (auto const &a : ev.acks)
+                    std::cout << "  ack " << a.request << ": " << status_names[static_cast<int>(a.status)]
+                              << " filled=" << a.filled << " leaves=" << a.leaves << "\n";
+            if (ev.type == EngineEvent::Type::TradeBatch)
+                std::cout << "  trades: " << ev.trades.size() << " (" << ev.trades.front().price << ".."
+                          << ev.trades.back().price << ")\n";
+            if (ev.type == EngineEvent::Type::Halted) std::cout << "  HALTED by order " << ev.summary.taker_id << "\n";
+            if (ev.type == EngineEvent::Type::Resumed) {
+                std::cout << "  resumed: uncross at " << ev.summary.last_price << ", " << ev.summary.filled_qty
+                          << " traded, best bid " << (eng.best_bid() ? std::to_string(*eng.best_bid()) : "-")
+                          << " best ask " << (eng.best_ask() ? std::to_string(*eng.best_ask()) : "-") << "\n";
+                break;
+            }
+        }
+    }
+
+    auto ops = DifferentialFuzzer::random_ops(9, 2000000);
+    for (bool on : {false, true}) {
+        OrderBook b;
+        if (on) b.set_price_controls(PriceControls{100, 5000, 5000, std::chrono::seconds(1)}); // never trips here
+        std::vector<Trade> buf;
+        auto start = Clock::now();
+        for (auto const &op : ops) {
+            if (op.cancel) b.cancel(op.id);
+            else { buf.clear(); b.add_order(Order{ op.id, op.side, op.price, op.qty, {} }, buf); }
+        }
+        double sec = std::chrono::duration<double>(Clock::now() - start).count();
+        std::cout << "controls " << (on ? "on " : "off") << ": "
+                  << static_cast<std::uint64_t>(static_cast<double>(ops.size()) / sec) << " ops/s\n";
+    }
+    return 0;
+}
+
+// Loads a reference-data file, cross-checks the division-free tick/lot
+// tests against %, times them, and runs an engine with tick/lot rules.
+int main_instruments_demo() {
+    const char *path = "/tmp/xchange_instruments.txt";
+    {
+        std::ofstream f(path);
+        f << "# id symbol tick lot reference band_bps halt_bps halt_window_ms policy\n"
+             "0 ACME   1  1   10000 500 300 1000 continuous\n"
+             "1 BOLT   4  100 20000 500 300 1000 continuous\n"
+             "2 CRANE  5  10  15000 1000 0  1000 continuous\n"
+             "3 DYNAMO 25 3   40000 0   0   1000 auction   # opens in auction\n";
+    }
+    InstrumentTable table = InstrumentTable::load(path);
+    static const char *kinds[] = {"one", "pow2", "general"};
+    table.for_each([&](const InstrumentSpec &s) {
+        InstrumentRules r(s);
+        std::cout << s.id << " " << s.symbol << " tick=" << s.tick << "(" << kinds[static_cast<int>(r.tick.kind())]
+                  << ") lot=" << s.lot << "(" << kinds[static_cast<int>(r.lot.kind())] << ") band=+-"
+                  << s.controls.band_bps << "bps " << (s.policy == MatchingPolicy::Auction ? "auction" : "continuous") << "\n";
+    });
+
+    std::mt19937_64 rng(17);
+    std::size_t mismatches = 0;
+    for (std::uint64_t d : {1ull, 2ull, 4ull, 5ull, 6ull, 7ull, 12ull, 25ull, 100ull, 1000ull, 1ull << 40, 0xfffffffbull}) {
+        Divisor div(d);
+        for (int i = 0; i < 200000; ++i) {
+            std::uint64_t x = i % 2 ? rng() : (rng() % 1000000) * (i % 3 ? d : 1);
+            if (div.divides(x) != (x % d == 0)) ++mismatches;
+        }
+    }
+    std::cout << "divisibility mismatches vs %: " << mismatches << "\n";
+
+    std::vector<std::pair<Price, Qty>> orders(1 << 20);
+    for (auto &o : orders) o = {static_cast<Price>(15000 + rng() % 1000), static_cast<Qty>(rng() % 200)};
+    const InstrumentRules &rules = *table.rules(2);
+    for (int pass = 0; pass < 2; ++pass) {
+        std::size_t ok = 0;
+        auto t0 = Clock::now();
+        for (int rep = 0; rep < 20; ++rep) {
+            if (pass == 0) {
+                for (auto const &[px, q] : orders) ok += rules.validate(px, q) == RejectReason::None;
+            } else {
+                volatile Price tick = 5; // what a naive table lookup would divide by
+                volatile Qty lot = 10;
+                for (auto const &[px, q] : orders) ok += px % tick == 0 && q > 0 && q % lot == 0;
+            }
+        }
+        double ns = std::chrono::duration<double, std::nano>(Clock::now() - t0).count() / (20.0 * orders.size());
+        std::cout << (pass == 0 ? "rules.validate: " : "px % tick:      ") << ns << " ns/order (ok=" << ok << ")\n";
+    }
+
+    auto before = EngineMetrics::collect().counters[static_cast<std::size_t>(Counter::Rejects)];
+    std::atomic<SeqNo> sequenced{0};
+    AsyncMatchingEngine eng([&](const Command &c){ sequenced.store(c.seq, std::memory_order_relaxed); });
+    eng.set_instrument(*table.find(1)); // tick 4, lot 100, band +-5% of 20000
+    eng.submit(Order{ 1, Side::Sell, 20004, 300, {} }, Display::Lit, 1);
+    eng.submit(Order{ 2, Side::Sell, 20006, 300, {} }, Display::Lit, 2); // off tick
+    eng.submit(Order{ 3, Side::Buy, 20004, 150, {} }, Display::Lit, 3);  // odd lot
+    eng.submit(Order{ 4, Side::Buy, 22000, 100, {} }, Display::Lit, 4);  // outside band
+    eng.submit(Order{ 5, Side::Buy, 20004, 200, {} }, Display::Lit, 5);
+    std::size_t acks = 0, trades = 0;
+    EngineEvent ev;
+    while (acks < 5 && eng.wait_event(ev)) acks += ev.acks.size();
+    eng.shutdown();
+    do trades += ev.trades.size(); while (eng.poll_event(ev));
+    auto rejects = EngineMetrics::collect().counters[static_cast<std::size_t>(Counter::Rejects)] - before;
+    std::cout << "engine: rejects=" << rejects << " trades=" << trades << " sequenced=" << sequenced.load()
+              << " (controls + 2 orders) best_ask=" << (eng.best_ask() ? std::to_string(*eng.best_ask()) : "-") << "\n";
+    return mismatches == 0 && rejects == 3 && sequenced.load() == 3 ? 0 : 1;
+}
+
+// Reference data from text vs binary, then first-order latency of a cold
+// engine vs one that warmed up, with the time-to-ready.
+int main_startup_demo(std::size_t instruments, std::size_t warm_orders) {
+    const char *txt = "/tmp/xchange_instruments_bulk.txt", *bin = "/tmp/xchange_instruments_bulk.bin";
+    {
+        std::ofstream f(txt);
+        for (std::size_t i = 0; i < instruments; ++i)
+            f << i << " SYM" << i << " " << (i % 3 == 0 ? 1 : i % 3 == 1 ? 4 : 5) << " " << (i % 2 ? 100 : 1)
+              << " 10000 500 300 1000 continuous\n";
+    }
+    auto t0 = Clock::now();
+    InstrumentTable from_text = InstrumentTable::load(txt);
+    auto t1 = Clock::now();
+    from_text.save_binary(bin);
+    auto t2 = Clock::now();
+    InstrumentTable table = InstrumentTable::load_binary(bin);
+    auto t3 = Clock::now();
+    auto us = [](auto d) { return std::chrono::duration_cast<std::chrono::microseconds>(d).count(); };
+    std::cout << instruments << " instruments: text " << us(t1 - t0) << "us, binary " << us(t3 - t2) << "us ("
+              << (table.size() == from_text.size() ? "same" : "DIFFERENT") << ")\n";
+
+    TscClock::calibrate();
+    for (bool warm : {false, true}) {
+        auto start = Clock::now();
+        AsyncMatchingEngine eng({}, std::pmr::get_default_resource(), WarmupConfig{ warm ? warm_orders : 0 });
+        StartupReport r = eng.wait_ready();
+        auto ready = Clock::now();
+        eng.set_instrument(*table.find(0));
+        std::vector<std::int64_t> match_ns, e2e_ns;
+        for (OrderId id = 1; id <= 2000; id += 2) {
+            Price px = 10000 + static_cast<Price>(id % 50);
+            eng.submit(Order{ id, Side::Sell, px, 1, {} });
+            eng.submit(Order{ id + 1, Side::Buy, px, 1, {} });
+            EngineEvent ev;
+            while (eng.wait_event(ev) && ev.type != EngineEvent::Type::TradeBatch) {}
+            match_ns.push_back(TscClock::to_ns(ev.stamps.match_start, ev.stamps.match_end));
+            e2e_ns.push_back(TscClock::to_ns(ev.stamps.ingress, ev.stamps.match_end));
+        }
+        eng.shutdown();
+        std::int64_t first = match_ns.front(), first_e2e = e2e_ns.front();
+        std::sort(match_ns.begin() + 1, match_ns.end());
+        std::sort(e2e_ns.begin() + 1, e2e_ns.end());
+        std::cout << (warm ? "warm" : "cold") << ": ready in " << us(ready - start) << "us (prewarm "
+                  << us(r.prewarm) << "us, synthetic " << r.warm_orders << " orders/" << r.warm_trades << " trades in "
+                  << us(r.synthetic) << "us)\n  first order: match " << first << "ns, ingress->match " << first_e2e
+                  << "ns | median: " << match_ns[match_ns.size() / 2] << "ns, " << e2e_ns[e2e_ns.size() / 2] << "ns\n";
+    }
+    return 0;
+}
+
+// Random flow across near/far/spread books. After every op the cached
+// implied quotes must equal ones rebuilt from scratch, every implied fill
+// must come with both legs at the same qty, and no book may be crossed.
+int main_spread_demo(std::size_t n) {
+    const InstrumentId kNearId = 1, kFarId = 2, kSpreadId = 3;
+    CalendarSpreadShard shard(kNearId, kFarId, kSpreadId);
+    std::mt19937_64 rng(23);
+    std::vector<LegFill> fills;
+    std::vector<std::pair<InstrumentId, OrderId>> live;
+    std::size_t stale = 0, broken_legs = 0, crossed = 0, direct = 0, implied = 0;
+    for (OrderId id = 1; id <= n; ++id) {
+        std::uint64_t r = rng();
+        if (r % 4 == 0 && !live.empty()) {
+            std::size_t k = (r >> 8) % live.size();
+            shard.cancel(live[k].first, live[k].second);
+            live[k] = live.back();
+            live.pop_back();
+        } else {
+            InstrumentId inst = static_cast<InstrumentId>(1 + (r >> 4) % 3);
+            Price mid = inst == kNearId ? 1000 : inst == kFarId ? 990 : 10;
+            Side side = (r >> 6) & 1 ? Side::Sell : Side::Buy;
+            Price px = mid + static_cast<Price>((r >> 16) % 9) - 4 + (side == Side::Sell ? 2 : -2);
+            fills.clear();
+            shard.add_order(inst, Order{ id, side, px, 1 + static_cast<Qty>((r >> 32) % 10), {} }, fills);
+            live.emplace_back(inst, id);
+            std::map<InstrumentId, Qty> leg_qty;
+            Qty synthetic = 0;
+            for (auto const &f : fills) {
+                if (!f.implied) { ++direct; continue; }
+                if (f.trade.maker_id == 0) { synthetic += f.trade.qty; ++implied; }
+                else leg_qty[f.instrument] += f.trade.qty;
+            }
+            if (synthetic && (leg_qty.size() != 2 || leg_qty.begin()->second != synthetic
+                              || leg_qty.rbegin()->second != synthetic))
+                ++broken_legs;
+        }
+        for (InstrumentId inst : {kNearId, kFarId, kSpreadId}) {
+            for (Side sd : {Side::Buy, Side::Sell})
+                if (!(shard.implied(inst, sd) == shard.implied_from_scratch(inst, sd))) ++stale;
+            auto bb = shard.book(inst).best_bid(), ba = shard.book(inst).best_ask();
+            if (bb && ba && *bb >= *ba) ++crossed;
+        }
+    }
+    std::cout << n << " ops: direct fills=" << direct << " implied executions=" << implied
+              << " implied recomputes=" << shard.implied_updates() << " ("
+              << static_cast<double>(shard.implied_updates()) / static_cast<double>(n) << "/op)\n"
+              << "stale implieds=" << stale << " one-legged implied fills=" << broken_legs << " crossed books=" << crossed << "\n";
+    auto show = [&](const char *name, InstrumentId inst) {
+        auto b = shard.best(inst, Side::Buy), a = shard.best(inst, Side::Sell);
+        auto ib = shard.implied(inst, Side::Buy), ia = shard.implied(inst, Side::Sell);
+        std::cout << "  " << name << ": direct " << b.qty << "@" << b.price << " / " << a.qty << "@" << a.price
+                  << "  implied " << ib.qty << "@" << ib.price << " / " << ia.qty << "@" << ia.price << "\n";
+    };
+    show("near  ", kNearId);
+    show("far   ", kFarId);
+    show("spread", kSpreadId);
+    return stale == 0 && broken_legs == 0 && crossed == 0 ? 0 : 1;
+}
+
+// A walk through peg and midpoint behaviour, then a random flow checked
+// for crossed states, then lit-order cost with many resting pegs.
+int main_peg_demo(std::size_t n) {
+    PeggedOrderBook book;
+    std::vector<Trade> trades;
+    auto show_trades = [&](const char *what) {
+        std::cout << what << ":";
+        for (auto const &t : trades) std::cout << " " << t.maker_id << "->" << t.taker_id << " " << t.qty << "@" << t.price;
+        std::cout << (trades.empty() ? " no trades" : "") << "\n";
+        trades.clear();
+    };
+    book.add_order(Order{ 1, Side::Buy, 98, 10, {} }, trades);
+    book.add_order(Order{ 2, Side::Sell, 102, 10, {} }, trades);
+    book.add_peg(Order{ 10, Side::Buy, 0, 5, {} }, PegType::Primary, 0, trades);  // at the bid
+    book.add_peg(Order{ 11, Side::Buy, 0, 5, {} }, PegType::Primary, -1, trades); // a tick behind it
+    book.add_peg(Order{ 12, Side::Sell, 0, 4, {} }, PegType::Midpoint, 0, trades);
+    std::cout << "bid=" << *book.best_bid() << " ask=" << *book.best_ask() << " mid=" << *book.midpoint()
+              << " peg(0)=" << *book.peg_price(Side::Buy, 0) << " peg(-1)=" << *book.peg_price(Side::Buy, -1) << "\n";
+    book.add_order(Order{ 3, Side::Buy, 99, 10, {} }, trades); // new bid: both groups move, nothing reinserted
+    std::cout << "after bid 99: peg(0)=" << *book.peg_price(Side::Buy, 0) << " peg(-1)=" << *book.peg_price(Side::Buy, -1)
+              << " mid=" << (book.midpoint() ? std::to_string(*book.midpoint()) : "none (half tick)") << "\n";
+    book.add_order(Order{ 4, Side::Buy, 100, 2, {} }, trades); // rests; mid becomes 101
+    show_trades("buy 2@100");
+    book.add_order(Order{ 6, Side::Buy, 101, 3, {} }, trades); // price-improved by the midpoint sell
+    show_trades("buy 3@101");
+    book.add_order(Order{ 5, Side::Sell, 98, 30, {} }, trades); // lit 100, lit 99, peg(0)@100, peg(-1)@99, lit 98
+    show_trades("sell 30@98");
+
+    std::mt19937_64 rng(31);
+    PeggedOrderBook rb;
+    std::size_t crossed = 0, pegs = 0, mids = 0;
+    for (OrderId id = 100; id < 100 + n; ++id) {
+        std::uint64_t r = rng();
+        Side side = r & 1 ? Side::Sell : Side::Buy;
+        trades.clear();
+        switch ((r >> 1) % 8) {
+            case 0: rb.add_peg(Order{ id, side, 0, 1 + static_cast<Qty>((r >> 8) % 5), {} }, PegType::Primary,
+                               (side == Side::Buy ? -1 : 1) * static_cast<Price>((r >> 16) % 4), trades); ++pegs; break;
+            case 1: rb.add_peg(Order{ id, side, 0, 1 + static_cast<Qty>((r >> 8) % 5), {} }, PegType::Midpoint, 0, trades); ++mids; break;
+            case 2: rb.cancel(id - 1 - (r >> 20) % 50, trades); break;
+            default: rb.add_order(Order{ id, side, 100 + static_cast<Price>((r >> 24) % 11) - 5, 1 + static_cast<Qty>((r >> 8) % 8), {} }, trades);
+        }
+        auto b = rb.best_bid(), a = rb.best_ask();
+        if (b && a && *b >= *a) ++crossed;
+        if (rb.midpoint() && rb.midpoint_qty(Side::Buy) > 0 && rb.midpoint_qty(Side::Sell) > 0) ++crossed;
+    }
+    std::cout << n << " random ops (" << pegs << " primary pegs, " << mids << " midpoint): crossed states=" << crossed
+              << ", live pegs=" << rb.peg_count() << "\n";
+
+    for (std::size_t resting : {std::size_t{0}, std::size_t{100000}}) {
+        PeggedOrderBook pb;
+        std::vector<Trade> buf;
+        for (OrderId id = 1; id <= resting; ++id)
+            pb.add_peg(Order{ id, id % 2 ? Side::Buy : Side::Sell, 0, 1, {} }, PegType::Primary,
+                       (id % 2 ? -1 : 1) * static_cast<Price>(2 + id % 8), buf);
+        auto ops = DifferentialFuzzer::random_ops(5, 500000, 1); // stays inside the peg offsets
+        auto t0 = Clock::now();
+        for (auto const &op : ops) {
+            buf.clear();
+            if (op.cancel) pb.cancel(op.id + 1000000, buf);
+            else pb.add_order(Order{ op.id + 1000000, op.side, op.price, op.qty, {} }, buf);
+        }
+        double sec = std::chrono::duration<double>(Clock::now() - t0).count();
+        std::cout << "lit flow with " << resting << " resting pegs: "
+                  << static_cast<std::uint64_t>(static_cast<double>(ops.size()) / sec) << " ops/s\n";
+    }
+    return crossed == 0 ? 0 : 1;
+}
+
+// Hidden orders: a walkthrough of the priority rules, a random flow checked
+// against a brute-force reference, then lit-order cost with and without
+// hidden liquidity in the book.
+int main_hidden_demo(std::size_t n) {
+    OrderBook book;
+    std::vector<Trade> trades;
+    book.add_order(Order{ 1, Side::Sell, 100, 5, {} }, trades);
+    book.add_order(Order{ 2, Side::Sell, 100, 10, {} }, trades, Display::Hidden);
+    book.add_order(Order{ 3, Side::Sell, 100, 5, {} }, trades); // after 2 in time, still ahead of it
+    book.add_order(Order{ 4, Side::Sell, 99, 4, {} }, trades, Display::Hidden);
+    Qty shown = 0;
+    book.for_each_resting([&](Side, Price, OrderId, Qty q) { shown += q; });
+    std::cout << "best ask=" << *book.best_ask() << " displayed qty=" << shown << " resting orders=" << book.order_count() << "\n";
+    book.add_order(Order{ 5, Side::Buy, 100, 20, {} }, trades); // hidden 99, then lit 100 (1, 3), then hidden 100
+    std::cout << "buy 20@100:";
+    for (auto const &t : trades) std::cout << " " << t.maker_id << "->" << t.taker_id << " " << t.qty << "@" << t.price;
+    std::cout << "\n";
+
+    // Reference: every resting order in one vector, best picked by
+    // (price, lit before hidden, arrival) on each fill.
+    struct Resting { OrderId id; Side side; Price px; Qty qty; bool hidden; };
+    std::vector<Resting> ref;
+    auto ref_add = [&](Order o, bool hidden, std::vector<Trade> &out) {
+        bool buy = o.side == Side::Buy;
+        while (o.qty > 0) {
+            auto best = ref.end();
+            for (auto it = ref.begin(); it != ref.end(); ++it) {
+                if (it->side == o.side || (buy ? it->px > o.price : it->px < o.price)) continue;
+                if (best == ref.end() || (buy ? it->px < best->px : it->px > best->px)
+                    || (it->px == best->px && !it->hidden && best->hidden))
+                    best = it;
+            }
+            if (best == ref.end()) break;
+            Qty q = std::min(o.qty, best->qty);
+            out.push_back({best->id, o.id, best->px, q});
+            o.qty -= q;
+            if ((best->qty -= q) == 0) ref.erase(best);
+        }
+        if (o.qty > 0) ref.push_back({o.id, o.side, o.price, o.qty, hidden});
+    };
+
+    std::mt19937_64 rng(69);
+    OrderBook hb;
+    std::vector<Trade> want;
+    std::size_t mismatches = 0, hidden = 0;
+    for (OrderId id = 1; id <= n; ++id) {
+        std::uint64_t r = rng();
+        trades.clear();
+        want.clear();
+        if (r % 8 == 0) {
+            OrderId victim = id - 1 - (r >> 8) % 64;
+            auto it = std::find_if(ref.begin(), ref.end(), [&](const Resting &x) { return x.id == victim; });
+            bool in_ref = it != ref.end();
+            if (in_ref) ref.erase(it);
+            if (hb.cancel(victim) != in_ref) ++mismatches;
+            continue;
+        }
+        Order o{ id, r & 2 ? Side::Sell : Side::Buy, 95 + static_cast<Price>((r >> 16) % 11), 1 + static_cast<Qty>((r >> 24) % 9), {} };
+        bool h = (r >> 4) % 4 == 0;
+        hidden += h;
+        hb.add_order(o, trades, h ? Display::Hidden : Display::Lit);
+        ref_add(o, h, want);
+        if (trades.size() != want.size()
+            || !std::equal(trades.begin(), trades.end(), want.begin(), [](const Trade &a, const Trade &b) {
+                   return a.maker_id == b.maker_id && a.taker_id == b.taker_id && a.price == b.price && a.qty == b.qty;
+               }))
+            ++mismatches;
+    }
+    std::size_t hidden_resting = 0;
+    hb.for_each_hidden([&](Side, Price, OrderId, Qty) { ++hidden_resting; });
+    std::cout << n << " random ops (" << hidden << " hidden): mismatches vs reference=" << mismatches
+              << ", resting=" << hb.order_count() << " (" << hidden_resting << " hidden)\n";
+
+    auto ops = DifferentialFuzzer::random_ops(5, 500000, 1);
+    for (std::size_t resting : {std::size_t{0}, std::size_t{1000}}) {
+        OrderBook lb;
+        std::vector<Trade> buf;
+        for (OrderId id = 1; id <= resting; ++id) // far from the flow: never crossed
+            lb.add_order(Order{ id, id % 2 ? Side::Buy : Side::Sell, id % 2 ? 10 : 100000, 1, {} }, buf, Display::Hidden);
+        auto t0 = Clock::now();
+        for (auto const &op : ops) {
+            buf.clear();
+            if (op.cancel) lb.cancel(op.id + 1000000);
+            else lb.add_order(Order{ op.id + 1000000, op.side, op.price, op.qty, {} }, buf);
+        }
+        double sec = std::chrono::duration<double>(Clock::now() - t0).count();
+        std::cout << "lit flow with " << resting << " hidden orders resting: "
+                  << static_cast<std::uint64_t>(static_cast<double>(ops.size()) / sec) << " ops/s\n";
+    }
+    return mismatches == 0 ? 0 : 1;
+}
+
+// Acks: a few requests answered one by one, then a pipelined burst of n
+// requests with no waiting, matched back up by request id.
+int main_ack_demo(std::size_t n) {
+    static const char *status_names[] = {"accepted", "rejected", "cancelled", "cancel-rejected", "halted"};
+    static const char *reason_names[] = {"", "unknown-instrument", "tick", "lot", "price-band", "unknown-order"};
+    InstrumentSpec spec;
+    spec.tick = 2;
+    spec.lot = 10;
+    spec.controls = PriceControls{1000, 1000, 0};
+    {
+        AsyncMatchingEngine eng;
+        eng.set_instrument(spec);
+        eng.submit(Order{ 1, Side::Sell, 1000, 50, {} }, Display::Lit, 101);
+        eng.submit(Order{ 2, Side::Buy, 1001, 10, {} }, Display::Lit, 102);  // off tick
+        eng.submit(Order{ 3, Side::Buy, 1200, 10, {} }, Display::Lit, 103);  // outside the band
+        eng.submit(Order{ 4, Side::Buy, 1000, 20, {} }, Display::Lit, 104);  // trades
+        eng.submit(Order{ 5, Side::Buy, 1000, -10, {} }, Display::Lit, 107); // not a positive lot
+        eng.cancel(1, 105);
+        eng.cancel(1, 106);                                                // already gone
+        std::size_t got = 0;
+        EngineEvent ev;
+        while (got < 7 && eng.wait_event(ev)) {
+            if (ev.type != EngineEvent::Type::Acks) continue; // the batch's trades follow its acks
+            for (auto const &a : ev.acks) {
+                std::cout << "req " << a.request << " order " << a.order << " seq " << a.seq << ": "
+                          << status_names[static_cast<int>(a.status)];
+                if (a.reason != RejectReason::None) std::cout << " (" << reason_names[static_cast<int>(a.reason)] << ")";
+                if (a.status == AckStatus::Accepted) std::cout << " filled=" << a.filled << " leaves=" << a.leaves;
+                std::cout << "\n";
+                ++got;
+            }
+        }
+    }
+
+    AsyncMatchingEngine eng;
+    eng.set_instrument(spec);
+    std::vector<std::uint8_t> seen(n + 1);
+    std::size_t acks = 0, ack_events = 0, rejects = 0, out_of_order = 0;
+    RequestId last = 0;
+    std::thread gateway([&] {
+        EngineEvent ev;
+        while (acks < n && eng.wait_event(ev)) {
+            if (ev.type != EngineEvent::Type::Acks) continue;
+            ++ack_events;
+            for (auto const &a : ev.acks) {
+                if (a.request <= last) ++out_of_order;
+                last = a.request;
+                ++seen[a.request];
+                rejects += a.status == AckStatus::Rejected;
+                ++acks;
+            }
+        }
+    });
+    std::mt19937_64 rng(70);
+    auto t0 = Clock::now();
+    for (RequestId req = 1; req <= n; ++req) { // never waits for an answer
+        std::uint64_t r = rng();
+        Side side = r & 1 ? Side::Sell : Side::Buy;
+        Price px = 990 + 2 * static_cast<Price>((r >> 8) % 11) + (r % 64 == 0); // ~1 in 64 off tick
+        eng.submit(Order{ req, side, px, 10 * (1 + static_cast<Qty>((r >> 16) % 5)), {} }, Display::Lit, req);
+    }
+    gateway.join();
+    double sec = std::chrono::duration<double>(Clock::now() - t0).count();
+    std::size_t dupes = 0, missing = 0;
+    for (RequestId req = 1; req <= n; ++req) {
+        missing += seen[req] == 0;
+        dupes += seen[req] > 1;
+    }
+    std::cout << n << " pipelined requests: acks=" << acks << " in " << ack_events << " events ("
+              << static_cast<double>(acks) / static_cast<double>(std::max<std::size_t>(1, ack_events)) << " per event), rejects="
+              << rejects << ", missing=" << missing << " dupes=" << dupes << " out_of_order=" << out_of_order << ", "
+              << static_cast<std::uint64_t>(static_cast<double>(n) / sec) << " req/s\n";
+    return missing == 0 && dupes == 0 && out_of_order == 0 ? 0 : 1;
+}
+
+// Wraps `body` (fields from MsgType on, SOH-terminated) in a FIX 4.4
+// header and trailer.
+static std::string fix_message(const std::string &body) {
+    std::string m = "8=FIX.4.4\x01" "9=" + std::to_string(body.size()) + "\x01" + body;
+    unsigned sum = 0;
+    for (unsigned char ch : m) sum += ch;
+    char tail[8];
+    std::snprintf(tail, sizeof(tail), "10=%03u\x01", sum % 256);
+    return m + tail;
+}
+
+// FIX front end: a few decoded messages, a random stream fed in random
+// chunk sizes and checked field by field, decode cost against a naive
+// split/strtol parser, and a session routed into the engine.
+int main_fix_demo(std::size_t n) {
+    auto field = [](int tag, const std::string &v) { return std::to_string(tag) + "=" + v + "\x01"; };
+    auto header = [&](char type, std::uint64_t seq) {
+        return field(35, std::string(1, type)) + field(49, "CLIENT01") + field(56, "XCHANGE") + field(34, std::to_string(seq))
+             + field(52, "20261017-09:30:00.123");
+    };
+    auto px_text = [](Price ticks) { // 2 decimals
+        char b[32];
+        std::snprintf(b, sizeof(b), "%lld.%02lld", static_cast<long long>(ticks / 100), static_cast<long long>(ticks % 100));
+        return std::string(b);
+    };
+    std::mt19937_64 rng(71);
+    std::string stream;
+    std::vector<FixRequest> want;
+    std::uint64_t seq = 1;
+    stream += fix_message(header('A', seq++) + field(98, "0") + field(108, "30")); // Logon
+    for (std::size_t i = 0; i < n; ++i) {
+        std::uint64_t r = rng();
+        FixRequest q;
+        q.seq = seq++;
+        q.order = Order{ i + 1, r & 1 ? Side::Sell : Side::Buy, 9900 + static_cast<Price>((r >> 8) % 200),
+                         1 + static_cast<Qty>((r >> 16) % 500), {} };
+        q.display = (r >> 40) % 16 == 0 ? Display::Hidden : Display::Lit;
+        std::string order_fields = field(11, std::to_string(q.order.id)) + field(55, "ACME")
+                                 + field(54, q.order.side == Side::Buy ? "1" : "2") + field(60, "20261017-09:30:00.123")
+                                 + field(38, std::to_string(q.order.qty)) + field(40, "2") + field(44, px_text(q.order.price))
+                                 + (q.display == Display::Hidden ? field(111, "0") : "");
+        switch (i > 8 ? (r >> 24) % 4 : 0) {
+            case 1:
+                q.kind = FixRequest::Kind::Cancel;
+                q.msg_type = 'F';
+                q.orig = i - (r >> 32) % 8;
+                q.order = Order{};
+                q.display = Display::Lit;
+                stream += fix_message(header('F', q.seq) + field(41, std::to_string(q.orig)) + field(11, "0")
+                                      + field(55, "ACME") + field(54, "1"));
+                break;
+            case 2:
+                q.kind = FixRequest::Kind::Replace;
+                q.msg_type = 'G';
+                q.orig = i - (r >> 32) % 8;
+                stream += fix_message(header('G', q.seq) + field(41, std::to_string(q.orig)) + order_fields);
+                break;
+            default:
+                q.kind = FixRequest::Kind::NewOrder;
+                q.msg_type = 'D';
+                stream += fix_message(header('D', q.seq) + order_fields);
+        }
+        want.push_back(q);
+    }
+    std::string sample = stream.substr(stream.find("8=FIX", 1)); // first order
+    sample.resize(sample.find("\x01" "10=") + 8);
+    std::string shown = sample;
+    std::replace(shown.begin(), shown.end(), '\x01', '|');
+    std::cout << "scan path: " << fix_detail::kScanPath << "\n" << shown << "\n";
+    {
+        FixParser parser(2);
+        FixRequest q;
+        std::size_t used = 0;
+        FixStatus st = parser.parse(sample.data(), sample.size(), q, used);
+        std::cout << "  -> status=" << static_cast<int>(st) << " used=" << used << "/" << sample.size() << " seq=" << q.seq
+                  << " id=" << q.order.id << " " << (q.order.side == Side::Buy ? "BUY " : "SELL ") << q.order.qty << "@"
+                  << q.order.price << "\n";
+        sample[sample.size() - 9] ^= 1; // flip a bit in the body
+        st = parser.parse(sample.data(), sample.size(), q, used);
+        std::cout << "  corrupted -> status=" << static_cast<int>(st) << " (bad checksum)\n";
+    }
+
+    // Random chunking exercises the partial-message path.
+    FixSession session(2);
+    std::size_t got = 0, mismatches = 0;
+    auto check = [&](const FixRequest &q) {
+        const FixRequest &w = want[got++];
+        if (q.kind != w.kind || q.seq != w.seq || q.orig != w.orig || q.display != w.display || q.order.id != w.order.id
+            || q.order.side != w.order.side || q.order.price != w.order.price || q.order.qty != w.order.qty)
+            ++mismatches;
+    };
+    for (std::size_t off = 0; off < stream.size();) {
+        std::size_t chunk = std::min<std::size_t>(stream.size() - off, 1 + rng() % 1500);
+        if (!session.feed(stream.data() + off, chunk, check)) break;
+        off += chunk;
+    }
+    std::cout << n << " messages (" << stream.size() / 1024 << " KiB) in random chunks: decoded=" << got
+              << " mismatches=" << mismatches << " admin=" << session.stats().admin
+              << " rejected=" << session.stats().rejected << " gaps=" << session.stats().gaps << "\n";
+
+    // Whole stream in one feed (no copying) vs split + strtol + a map.
+    std::uint64_t sink = 0;
+    auto t0 = Clock::now();
+    FixSession fast(2);
+    fast.feed(stream.data(), stream.size(), [&](const FixRequest &q) { sink += q.order.qty; });
+    double fast_ns = std::chrono::duration<double, std::nano>(Clock::now() - t0).count() / static_cast<double>(n);
+    t0 = Clock::now();
+    std::unordered_map<int, std::string> fields;
+    for (std::size_t off = 0; off < stream.size();) {
+        std::size_t end = stream.find("\x01" "10=", off) + 8;
+        fields.clear();
+        for (std::size_t f = off; f < end;) {
+            std::size_t eq = stream.find('=', f), soh = stream.find('\x01', eq);
+            fields[std::atoi(stream.substr(f, eq - f).c_str())] = stream.substr(eq + 1, soh - eq - 1);
+            f = soh + 1;
+        }
+        if (fields[35] != "A") sink += std::strtoll(fields[38].c_str(), nullptr, 10)
+                                    + static_cast<std::uint64_t>(std::strtod(fields[44].c_str(), nullptr) * 100);
+        off = end;
+    }
+    double naive_ns = std::chrono::duration<double, std::nano>(Clock::now() - t0).count() / static_cast<double>(n);
+    std::cout << "decode: " << fast_ns << " ns/msg (" << static_cast<double>(stream.size()) / (fast_ns * static_cast<double>(n))
+              << " GB/s) vs naive " << naive_ns << " ns/msg [" << (sink & 1) << "]\n";
+
+    // Into the engine: one Ack per request, tagged with its MsgSeqNum.
+    std::size_t m = std::min<std::size_t>(n, 50000);
+    std::size_t m_bytes = 0;
+    for (std::size_t i = 0; i <= m; ++i) m_bytes = stream.find("8=FIX", m_bytes + 1);
+    AsyncMatchingEngine eng;
+    FixSession live(2);
+    live.feed(stream.data(), m_bytes, [&](const FixRequest &q) { route(eng, q); });
+    std::size_t acks = 0, seq_errors = 0;
+    std::uint64_t by_status[5] = {};
+    std::uint64_t expect_seq = 2; // after the Logon
+    EngineEvent ev;
+    while (acks < live.stats().requests && eng.wait_event(ev)) {
+        if (ev.type != EngineEvent::Type::Acks) continue;
+        for (auto const &a : ev.acks) {
+            seq_errors += a.request != expect_seq++;
+            ++by_status[static_cast<int>(a.status)];
+            ++acks;
+        }
+    }
+    std::cout << "engine: " << live.stats().requests << " requests, " << acks << " acks (accepted=" << by_status[0]
+              << " cancelled=" << by_status[2] << " cancel-rejected=" << by_status[3] << "), seq mismatches=" << seq_errors << "\n";
+    return mismatches == 0 && got == n && seq_errors == 0 ? 0 : 1;
+}
+
+// SBE egress: encode/decode cost, then an engine's trades, acks and depth
+// deltas streamed to a forked process that decodes them in place and
+// rebuilds the book's depth from the deltas alone.
+int main_sbe_demo(std::size_t n) {
+    struct Tally {
+        std::uint64_t trades = 0, traded_qty = 0, acks = 0, deltas = 0, depth_hash = 0, bytes = 0;
+    };
+    auto depth_hash = [](const std::map<std::pair<int, Price>, std::pair<Qty, std::uint32_t>> &levels) {
+        std::uint64_t h = 1469598103934665603ull;
+        for (auto const &[k, v] : levels)
+            for (std::uint64_t x : {static_cast<std::uint64_t>(k.first), static_cast<std::uint64_t>(k.second),
+                                    static_cast<std::uint64_t>(v.first), std::uint64_t{v.second}})
+                h = (h ^ x) * 0x100000001b3ull;
+        return h;
+    };
+
+    {
+        std::vector<char> buf(1 << 20);
+        SbeWriter w(buf.data(), buf.size());
+        constexpr std::size_t kMsgs = (1 << 20) / (sizeof(SbeHeader) + SbeFlyweight<TradeMessage>::kBlockLength);
+        auto t0 = Clock::now();
+        for (int rep = 0; rep < 20; ++rep) {
+            w.clear();
+            for (std::size_t i = 0; i < kMsgs; ++i)
+                sbe_encode(w, 7, Trade{i, i + 1, 100 + static_cast<Price>(i % 16), static_cast<Qty>(1 + i % 9)});
+        }
+        double enc = std::chrono::duration<double, std::nano>(Clock::now() - t0).count() / (20.0 * kMsgs);
+        Qty sum = 0;
+        t0 = Clock::now();
+        for (int rep = 0; rep < 20; ++rep)
+            sbe_for_each(w.data(), w.size(), [&](const SbeHeader &h, const char *block) {
+                if (auto t = sbe_view<TradeMessage>(h, block)) sum += t->get<TradeMessage::kQty>();
+            });
+        double dec = std::chrono::duration<double, std::nano>(Clock::now() - t0).count() / (20.0 * kMsgs);
+        std::cout << "trade message: " << sizeof(SbeHeader) + SbeFlyweight<TradeMessage>::kBlockLength << " bytes, encode "
+                  << enc << " ns, decode " << dec << " ns [" << (sum & 1) << "]\n";
+    }
+
+    int fds[2];
+    if (::socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0) {
+        std::perror("socketpair");
+        return 1;
+    }
+    pid_t child = ::fork();
+    if (child == 0) { // consumer process: decode in place, never parse
+        ::close(fds[0]);
+        Tally t;
+        std::map<std::pair<int, Price>, std::pair<Qty, std::uint32_t>> levels;
+        std::vector<char> buf(1 << 16);
+        std::size_t have = 0;
+        for (;;) {
+            ssize_t r = ::read(fds[1], buf.data() + have, buf.size() - have);
+            if (r <= 0) break;
+            t.bytes += static_cast<std::uint64_t>(r);
+            have += static_cast<std::size_t>(r);
+            std::size_t used = sbe_for_each(buf.data(), have, [&](const SbeHeader &h, const char *block) {
+                if (auto m = sbe_view<TradeMessage>(h, block)) {
+                    ++t.trades;
+                    t.traded_qty += static_cast<std::uint64_t>(m->get<TradeMessage::kQty>());
+                } else if (auto a = sbe_view<AckMessage>(h, block)) {
+                    ++t.acks;
+                } else if (auto d = sbe_view<BookDeltaMessage>(h, block)) {
+                    ++t.deltas;
+                    std::pair<int, Price> key{d->get<BookDeltaMessage::kSide>(), d->get<BookDeltaMessage::kPrice>()};
+                    if (d->get<BookDeltaMessage::kQty>() == 0) levels.erase(key);
+                    else levels[key] = {d->get<BookDeltaMessage::kQty>(), d->get<BookDeltaMessage::kOrders>()};
+                }
+            });
+            std::memmove(buf.data(), buf.data() + used, have - used);
+            have -= used;
+        }
+        t.depth_hash = depth_hash(levels);
+        replication_detail::write_all(fds[1], &t, sizeof(t));
+        ::_exit(0);
+    }
+    ::close(fds[1]);
+
+    AsyncMatchingEngine eng;
+    eng.set_depth_view(true);
+    auto depth = eng.depth_reader();
+    std::thread producer([&] {
+        std::mt19937_64 rng(72);
+        for (OrderId id = 1; id <= n; ++id) {
+            std::uint64_t r = rng();
+            eng.submit(Order{ id, r & 1 ? Side::Sell : Side::Buy, 95 + static_cast<Price>((r >> 8) % 11),
+                              1 + static_cast<Qty>((r >> 16) % 9), {} }, Display::Lit, id);
+        }
+    });
+    Tally sent;
+    std::vector<char> buf(1 << 16);
+    SbeWriter w(buf.data(), buf.size());
+    auto flush = [&] {
+        replication_detail::write_all(fds[0], w.data(), w.size());
+        sent.bytes += w.size();
+        w.clear();
+    };
+    auto put = [&](auto &&encode) { // flush and retry once when the buffer is full
+        if (!encode()) {
+            flush();
+            encode();
+        }
+    };
+    DepthSnapshot prev;
+    auto send_depth = [&] {
+        auto snap = depth.pin();
+        if (!snap || snap->seq == prev.seq) return;
+        std::size_t worst = prev.bids.size() + prev.asks.size() + snap->bids.size() + snap->asks.size();
+        if (w.remaining() < worst * (sizeof(SbeHeader) + SbeFlyweight<BookDeltaMessage>::kBlockLength)) flush();
+        sbe_encode_depth(w, 0, &prev, *snap);
+        prev = *snap;
+    };
+    auto send = [&](const EngineEvent &ev) {
+        for (auto const &t : ev.trades) {
+            sent.trades += 1;
+            sent.traded_qty += static_cast<std::uint64_t>(t.qty);
+            put([&] { return sbe_encode(w, 0, t); });
+        }
+        for (auto const &a : ev.acks) put([&] { return sbe_encode(w, a); });
+        sent.acks += ev.acks.size();
+        // Each batch leads with its acks, and its depth is published before
+        // its events, so this snapshot covers at least the batch.
+        if (ev.type == EngineEvent::Type::Acks) send_depth();
+        if (w.remaining() < 8192) flush();
+    };
+    EngineEvent ev;
+    while (sent.acks < n && eng.wait_event(ev)) send(ev);
+    while (eng.poll_event(ev)) send(ev); // rest of the last batch
+    send_depth();
+    flush();
+    producer.join();
+    ::shutdown(fds[0], SHUT_WR);
+    Tally got;
+    std::size_t have = 0;
+    while (have < sizeof(got)) {
+        ssize_t r = ::read(fds[0], reinterpret_cast<char *>(&got) + have, sizeof(got) - have);
+        if (r <= 0) break;
+        have += static_cast<std::size_t>(r);
+    }
+    ::waitpid(child, nullptr, 0);
+    ::close(fds[0]);
+
+    std::map<std::pair<int, Price>, std::pair<Qty, std::uint32_t>> final_levels;
+    for (auto const &l : prev.bids) final_levels[{0, l.price}] = {l.qty, l.orders};
+    for (auto const &l : prev.asks) final_levels[{1, l.price}] = {l.qty, l.orders};
+    bool same = got.trades == sent.trades && got.traded_qty == sent.traded_qty && got.acks == sent.acks
+             && got.bytes == sent.bytes && got.depth_hash == depth_hash(final_levels);
+    std::cout << "child decoded " << got.bytes / 1024 << " KiB: trades=" << got.trades << "/" << sent.trades
+              << " acks=" << got.acks << "/" << sent.acks << " deltas=" << got.deltas
+              << " depth rebuilt from deltas matches=" << (got.depth_hash == depth_hash(final_levels) ? "yes" : "NO")
+              << " (" << final_levels.size() << " levels)\n";
+    return same ? 0 : 1;
+}
+
+// Compressed journal: size and encode/decode rate against the raw format on
+// a synthetic day, a lossless round trip, then a flipped byte (caught by the
+// block checksum) and a torn tail (dropped silently).
+int main_compress_demo(std::size_t n) {
+    const std::string raw_path = "/tmp/xchange_compress.jnl";
+    const std::string z_path = "/tmp/xchange_compress.jnlz";
+    write_synthetic_day(raw_path, n, 73, 16);
+    std::vector<Command> in;
+    {
+        MappedJournal raw(raw_path);
+        in.assign(raw.begin(), raw.end());
+    }
+    for (auto &c : in) { // exercise the rarer fields too
+        if (c.seq % 7 == 0) { c.request = c.seq; c.ingress_tsc = 1'000'000 + c.seq * 37; }
+        if (c.seq % 11 == 0 && c.type == Command::Type::NewOrder) c.display = Display::Hidden;
+        if (c.seq % 13 == 0 && c.type == Command::Type::NewOrder) { c.type = Command::Type::Replace; c.replaces = c.order.id - 3; }
+        if (c.seq % 5003 == 0) {
+            SeqNo seq = c.seq;
+            c = Command{};
+            c.seq = seq;
+            c.type = Command::Type::Resume;
+            c.instrument = 1;
+        }
+        if (c.seq % 5009 == 0) {
+            SeqNo seq = c.seq;
+            c = controls_command(PriceControls{10000, 500, 300, std::chrono::milliseconds(250)}, true);
+            c.seq = seq;
+        }
+    }
+    std::remove(z_path.c_str());
+    auto t0 = Clock::now();
+    std::uint64_t z_bytes = 0;
+    {
+        CompressedJournalWriter out(z_path);
+        for (auto const &c : in) out.append(c);
+        out.flush();
+        z_bytes = out.bytes_written();
+    }
+    double enc = std::chrono::duration<double>(Clock::now() - t0).count();
+
+    auto same = [](const Command &a, const Command &b) {
+        return a.seq == b.seq && a.type == b.type && a.display == b.display && a.instrument == b.instrument
+            && a.order.id == b.order.id && a.order.side == b.order.side && a.order.price == b.order.price
+            && a.order.qty == b.order.qty && a.order.ts == b.order.ts && a.ingress_tsc == b.ingress_tsc
+            && a.request == b.request && a.replaces == b.replaces && a.clock_ns == b.clock_ns;
+    };
+    // Reads `path` back; returns records that matched `in` in order.
+    auto read_back = [&](const std::string &path, bool &corrupt) {
+        CompressedJournalReader rd(path);
+        std::size_t k = 0;
+        Command c;
+        while (rd.next(c) && k < in.size() && same(c, in[k])) ++k;
+        corrupt = rd.corrupt();
+        return k;
+    };
+    bool corrupt = false;
+    t0 = Clock::now();
+    std::size_t round_trip = read_back(z_path, corrupt);
+    double dec = std::chrono::duration<double>(Clock::now() - t0).count();
+    bool ok = round_trip == in.size() && !corrupt;
+
+    std::uint64_t raw_bytes = sizeof(JournalFileHeader) + in.size() * sizeof(Command);
+    std::cout << n << " records: raw " << raw_bytes / 1024 << " KiB, compressed " << z_bytes / 1024 << " KiB ("
+              << static_cast<double>(raw_bytes) / static_cast<double>(z_bytes) << "x, "
+              << static_cast<double>(z_bytes) / static_cast<double>(n) << " B/record)\n"
+              << "encode " << static_cast<double>(n) / enc / 1e6 << " M records/s, decode "
+              << static_cast<double>(n) / dec / 1e6 << " M records/s, round trip "
+              << (ok ? "lossless" : "MISMATCH") << "\n";
+
+    std::vector<char> file;
+    {
+        std::ifstream f(z_path, std::ios::binary);
+        file.assign(std::istreambuf_iterator<char>(f), {});
+    }
+    auto write_file = [&](std::size_t len) {
+        std::ofstream(z_path, std::ios::binary | std::ios::trunc).write(file.data(), static_cast<std::streamsize>(len));
+    };
+    std::size_t mid = file.size() / 2;
+    file[mid] = static_cast<char>(file[mid] ^ 0x10);
+    write_file(file.size());
+    std::size_t before_flip = read_back(z_path, corrupt);
+    bool flip_ok = corrupt && before_flip < in.size();
+    file[mid] = static_cast<char>(file[mid] ^ 0x10);
+    write_file(file.size() - 100);
+    std::size_t before_tear = read_back(z_path, corrupt);
+    bool tear_ok = !corrupt && before_tear < in.size() && before_tear > before_flip;
+    std::cout << "flipped byte: stopped after " << before_flip << " records, corrupt=" << (flip_ok ? "yes" : "NO")
+              << "; torn tail: " << before_tear << " records, clean=" << (tear_ok ? "yes" : "NO") << "\n";
+    std::remove(raw_path.c_str());
+    std::remove(z_path.c_str());
+    return ok && flip_ok && tear_ok ? 0 : 1;
+}
+
+// Journal writer stage: the engine journals through AsyncJournalWriter and
+// acks are released only once durable_seq() covers them. Runs io_uring and
+// pwrite, reads each journal back, then SIGKILLs a child mid-stream and
+// checks every ack it had released is in its journal.
+int main_journal_demo(std::size_t n) {
+    const std::string path = "/tmp/xchange_async.jnl";
+    auto order = [](std::uint64_t i) {
+        std::uint64_t r = i * 0x9e3779b97f4a7c15ull;
+        return Order{ i, (r >> 7) & 1 ? Side::Sell : Side::Buy, 95 + static_cast<Price>((r >> 11) % 11),
+                      1 + static_cast<Qty>((r >> 19) % 9), {} };
+    };
+    // Submits `count` orders (0 = until killed); released(seq) per ack sent.
+    auto run = [&](AsyncJournalWriter &jnl, std::size_t count, auto &&released) {
+        AsyncMatchingEngine eng(jnl.sink());
+        std::thread producer([&] {
+            for (OrderId id = 1; count == 0 || id <= count; ++id) eng.submit(order(id), Display::Lit, id);
+        });
+        DurableAckGate gate;
+        std::size_t sent = 0, trades = 0, max_held = 0;
+        EngineEvent ev;
+        auto take = [&] {
+            trades += ev.trades.size();
+            for (auto const &a : ev.acks) gate.hold(a);
+            max_held = std::max(max_held, gate.held());
+        };
+        while (count == 0 || sent < count) {
+            if (eng.poll_event(ev)) take();
+            else if (gate.held() > 0) jnl.wait_durable(jnl.durable_seq() + 1); // nothing new: wait on the disk
+            else if (eng.wait_event(ev)) take();
+            else break;
+            sent += gate.release(jnl.durable_seq(), released);
+        }
+        producer.join();
+        while (eng.poll_event(ev)) trades += ev.trades.size();
+        eng.shutdown();
+        return std::pair{trades, max_held};
+    };
+
+    bool ok = true;
+    for (bool uring : {true, false}) {
+        AsyncJournalConfig cfg;
+        cfg.use_uring = uring;
+        std::size_t trades = 0, max_held = 0;
+        SeqNo worst = 0;
+        double sec = 0;
+        const char *backend = "?";
+        bool direct = false;
+        std::uint64_t writes = 0;
+        {
+            AsyncJournalWriter jnl(path, cfg);
+            backend = jnl.backend() == JournalBackend::IoUring ? "io_uring" : "pwrite";
+            direct = jnl.direct();
+            auto t0 = Clock::now();
+            std::tie(trades, max_held) = run(jnl, n, [&](const Ack &a) {
+                if (a.seq > jnl.durable_seq()) worst = std::max(worst, a.seq); // released too early
+            });
+            sec = std::chrono::duration<double>(Clock::now() - t0).count();
+            writes = jnl.writes();
+        }
+        OrderBook ref;
+        std::vector<Trade> fills;
+        JournalReader rd(path);
+        Command c;
+        SeqNo expect = 1;
+        std::size_t ref_trades = 0;
+        while (rd.next(c) && c.seq == expect) {
+            ++expect;
+            fills.clear();
+            ref.add_order(c.order, fills);
+            ref_trades += fills.size();
+        }
+        bool good = expect == n + 1 && ref_trades == trades && worst == 0;
+        ok = ok && good;
+        std::cout << backend << (direct ? " + O_DIRECT" : "") << ": " << static_cast<std::uint64_t>(static_cast<double>(n) / sec)
+                  << " acked orders/s, " << writes << " writes (" << static_cast<double>(n) / static_cast<double>(writes)
+                  << " records each), max acks held " << max_held << ", journal replays "
+                  << (good ? "identically" : "DIFFERENTLY") << "\n";
+    }
+
+    int fds[2];
+    if (::pipe(fds) != 0) {
+        std::perror("pipe");
+        return 1;
+    }
+    pid_t child = ::fork();
+    if (child == 0) {
+        ::close(fds[0]);
+        AsyncJournalWriter jnl(path);
+        run(jnl, 0, [&](const Ack &a) { (void)!::write(fds[1], &a.seq, sizeof(a.seq)); });
+        ::_exit(0);
+    }
+    ::close(fds[1]);
+    SeqNo released = 0;
+    std::thread acks([&] { // the child's clients
+        SeqNo seq;
+        while (replication_detail::read_all(fds[0], &seq, sizeof(seq))) released = std::max(released, seq);
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+    ::kill(child, SIGKILL);
+    ::waitpid(child, nullptr, 0);
+    acks.join();
+    ::close(fds[0]);
+    JournalReader rd(path);
+    Command c;
+    SeqNo journaled = 0;
+    while (rd.next(c) && c.seq == journaled + 1) ++journaled;
+    bool crash_ok = released > 0 && journaled >= released;
+    std::cout << "killed mid-stream: acks released through seq " << released << ", journal holds 1.." << journaled
+              << " -> " << (crash_ok ? "no acked order lost" : "ACKED ORDER LOST") << "\n";
+    std::remove(path.c_str());
+    return ok && crash_ok ? 0 : 1;
+}
+
+// CRC32C: hardware and table paths agree (and match the reference check
+// value), their throughput, then a replay that verifies in parallel and
+// refuses a journal with one flipped byte.
+int main_crc_demo(std::size_t events) {
+    const char *check = "123456789";
+    std::uint32_t hw = crc32c(check, 9);
+    std::uint32_t sw = ~crc32c_detail::software(~0u, reinterpret_cast<const unsigned char *>(check), 9);
+    std::vector<unsigned char> data(64 << 20);
+    std::mt19937_64 rng(75);
+    for (auto &b : data) b = static_cast<unsigned char>(rng());
+    auto rate = [&](auto &&f) {
+        auto t0 = Clock::now();
+        std::uint32_t c = f();
+        double sec = std::chrono::duration<double>(Clock::now() - t0).count();
+        return std::pair{c, static_cast<double>(data.size()) / sec / 1e9};
+    };
+    auto [hw_big, hw_gbs] = rate([&] { return crc32c(data.data(), data.size()); });
+    auto [sw_big, sw_gbs] = rate([&] { return ~crc32c_detail::software(~0u, data.data(), data.size()); });
+    bool agree = hw == 0xe3069283u && sw == hw && sw_big == hw_big;
+    std::cout << crc32c_backend() << ": " << hw_gbs << " GB/s, software: " << sw_gbs << " GB/s, check value "
+              << (agree ? "matches" : "MISMATCH") << "\n";
+
+    const std::string path = "/tmp/xchange_crc.jnl";
+    write_synthetic_day(path, events, 75, 16);
+    ParallelReplayer replayer(2);
+    auto t0 = Clock::now();
+    auto res = replayer.replay(path);
+    double sec = std::chrono::duration<double>(Clock::now() - t0).count();
+    std::size_t commands = 0;
+    for (auto const &r : res) commands += r.commands;
+
+    std::size_t victim = sizeof(JournalFileHeader) + (events / 2) * sizeof(Command) + offsetof(Command, order.price);
+    {
+        std::fstream f(path, std::ios::in | std::ios::out | std::ios::binary);
+        f.seekg(static_cast<std::streamoff>(victim));
+        char b = static_cast<char>(f.get() ^ 0x04);
+        f.seekp(static_cast<std::streamoff>(victim));
+        f.put(b);
+    }
+    std::string refused;
+    try {
+        replayer.replay(path);
+    } catch (const std::runtime_error &e) {
+        refused = e.what();
+    }
+    JournalReader rd(path);
+    Command c;
+    std::size_t readable = 0;
+    while (rd.next(c)) ++readable;
+    std::remove(path.c_str());
+    bool ok = agree && commands == events && !refused.empty() && readable == events / 2 && rd.corrupt();
+    std::cout << "verified replay: " << static_cast<std::uint64_t>(static_cast<double>(events) / sec)
+              << " events/s, " << commands << " applied\n"
+              << "flipped byte: " << (refused.empty() ? "NOT DETECTED" : refused) << "; JournalReader stops after "
+              << readable << " records, corrupt=" << (rd.corrupt() ? "yes" : "no") << "\n";
+    return ok ? 0 : 1;
+}
+
+#ifdef XCHANGE_FUZZER
+// clang++ -std=gnu++20 -O1 -g -fsanitize=fuzzer,address -DXCHANGE_FUZZER main.cpp
+extern "C" int LLVMFuzzerTestOneInput(const std::uint8_t *data, std::size_t size) {
+    auto ops = DifferentialFuzzer::decode_ops(data, size);
+    DifferentialFuzzer fz = make_fuzzer(ops.size()); // pools fit the input, so exhaustion is never a finding
+    if (auto f = fz.run(ops)) {
+        std::cerr << f->variant << " diverged at step " << f->step << "\n" << f->detail;
+        std::abort();
+    }
+    return 0;
+}
+#else
+int main(int argc, char **argv) {
+    std::string mode = argc > 1 ? argv[1] : "";
+    if (mode == "replication") return main_replication_demo();
+    if (mode == "persist") return main_persist_demo();
+    if (mode == "bench-cancel") return main_bench_cancel();
+    if (mode == "latency") return main_latency_demo();
+    if (mode == "flight") return main_flight_demo();
+    if (mode == "fuzz") return main_fuzz_demo(argc > 2 ? std::stoull(argv[2]) : 2000000);
+    if (mode == "backtest") return main_backtest_demo(argc > 2 ? std::stoull(argv[2]) : 2000000, 4);
+    if (mode == "replay") return main_replay_demo(argc > 2 ? std::stoull(argv[2]) : 4000000, 64);
+    if (mode == "bench-batch") return main_bench_batch(argc > 2 ? std::stoull(argv[2]) : 1000000);
+    if (mode == "exec-summary") return main_exec_summary_demo();
+    if (mode == "stats") return main_stats_demo(argc > 2 ? std::stoull(argv[2]) : 200000);
+    if (mode == "depth") return main_depth_demo(argc > 2 ? std::stoull(argv[2]) : 200000);
+    if (mode == "bands") return main_bands_demo();
+    if (mode == "instruments") return main_instruments_demo();
+    if (mode == "startup") return main_startup_demo(argc > 2 ? std::stoull(argv[2]) : 100000, 65536);
+    if (mode == "spread") return main_spread_demo(argc > 2 ? std::stoull(argv[2]) : 200000);
+    if (mode == "peg") return main_peg_demo(argc > 2 ? std::stoull(argv[2]) : 200000);
+    if (mode == "hidden") return main_hidden_demo(argc > 2 ? std::stoull(argv[2]) : 100000);
+    if (mode == "ack") return main_ack_demo(argc > 2 ? std::stoull(argv[2]) : 200000);
+    if (mode == "fix") return main_fix_demo(argc > 2 ? std::stoull(argv[2]) : 200000);
+    if (mode == "sbe") return main_sbe_demo(argc > 2 ? std::stoull(argv[2]) : 200000);
+    if (mode == "journal") return main_journal_demo(argc > 2 ? std::stoull(argv[2]) : 200000);
+    if (mode == "crc") return main_crc_demo(argc > 2 ? std::stoull(argv[2]) : 2000000);
+    if (mode == "compress") return main_compress_demo(argc > 2 ? std::stoull(argv[2]) : 4000000);
+    if (mode == "metrics") return main_metrics_demo(argc > 2 ? static_cast<std::uint16_t>(std::stoi(argv[2])) : 0);
+    if (mode == "flight-decode" && argc > 2) return flight_decode(argv[2], std::cout) ? 0 : 1;
+
     std::cout << "=== SYNC DEMO ===\n";
     main_sync_demo();
 
     std::cout << "\n=== ASYNC DEMO ===\n";
     return main_async_demo();
 }
+#endif